@@ -0,0 +1,114 @@
+/*
+*Scripted pad input for the host build.
+*
+*Script lines are "<frame> [buttons...]", the listed buttons are held from that
+*frame until the next line. "repeat <frames>" loops the script with that period.
+*Lines starting with # are comments.
+*/
+#include <ctype.h>
+#define BAG_HOST_SHIM
+#include "libBAG.h"
+
+typedef struct InputEvent_t{
+    unsigned long frame;
+    unsigned int held;
+}InputEvent_t;
+
+static const char *buttonNames[] = {
+    "A", "B", "X", "Y", "L", "R", "Start", "Select",
+    "Up", "Down", "Left", "Right", "Touch",
+};
+#define BUTTON_COUNT (sizeof(buttonNames) / sizeof(buttonNames[0]))
+
+static InputEvent_t *Events = NULL;
+static int EventCount = 0;
+static unsigned long RepeatPeriod = 0;
+static __thread unsigned int LastHeld = 0;//per thread like Pad
+
+static int parseButton(const char *name){
+    for(unsigned int i = 0; i < BUTTON_COUNT; i++){
+        if(!strcasecmp(name, buttonNames[i]))
+            return i;
+    }
+    return -1;
+}
+
+int BAG_Host_LoadInput(const char *file){
+    FILE *script = fopen(file, "r");
+    if(script == NULL)
+        return 0;
+
+    char line[256];
+    int lineNum = 0;
+    while(fgets(line, sizeof(line), script)){
+        lineNum++;
+        char *tok = strtok(line, " \t\r\n");
+        if(tok == NULL || tok[0] == '#')
+            continue;
+
+        if(!strcasecmp(tok, "repeat")){
+            tok = strtok(NULL, " \t\r\n");
+            RepeatPeriod = tok ? strtoul(tok, NULL, 10) : 0;
+            continue;
+        }
+        if(!isdigit((unsigned char)tok[0])){
+            printf("%s:%d: expected a frame number\n", file, lineNum);
+            continue;
+        }
+
+        InputEvent_t ev = {strtoul(tok, NULL, 10), 0};
+        while((tok = strtok(NULL, " \t\r\n")) != NULL){
+            int button = parseButton(tok);
+            if(button < 0)
+                printf("%s:%d: unknown button %s\n", file, lineNum, tok);
+            else
+                SET_FLAG(ev.held, 1 << button);
+        }
+
+        InputEvent_t *temp = realloc(Events, (EventCount + 1) * sizeof(InputEvent_t));
+        if(temp == NULL)
+            break;
+        Events = temp;
+        Events[EventCount++] = ev;
+    }
+    fclose(script);
+    return 1;
+}
+
+static unsigned int heldAtFrame(unsigned long frame){
+    if(RepeatPeriod)
+        frame %= RepeatPeriod;
+
+    unsigned int held = 0;
+    for(int i = 0; i < EventCount && Events[i].frame <= frame; i++)
+        held = Events[i].held;
+    return held;
+}
+
+static void maskToButtons(unsigned int mask, PadButtons_t *buttons){
+    memset(buttons, 0, sizeof(PadButtons_t));
+    buttons->A = (mask >> 0) & 1;
+    buttons->B = (mask >> 1) & 1;
+    buttons->X = (mask >> 2) & 1;
+    buttons->Y = (mask >> 3) & 1;
+    buttons->L = (mask >> 4) & 1;
+    buttons->R = (mask >> 5) & 1;
+    buttons->Start = (mask >> 6) & 1;
+    buttons->Select = (mask >> 7) & 1;
+    buttons->Up = (mask >> 8) & 1;
+    buttons->Down = (mask >> 9) & 1;
+    buttons->Left = (mask >> 10) & 1;
+    buttons->Right = (mask >> 11) & 1;
+    buttons->Touch = (mask >> 12) & 1;
+}
+
+void BAG_Host_SetPad(unsigned int held){
+    maskToButtons(held, &Pad.Held);
+    maskToButtons(held & ~LastHeld, &Pad.Newpress);
+    maskToButtons(LastHeld & ~held, &Pad.Released);
+    LastHeld = held;
+}
+
+void BAG_Host_UpdateInput(unsigned long frame){
+    BAG_Host_SetPad(Events ? heldAtFrame(frame) : 0);
+}
@@ -0,0 +1,487 @@
+/*
+*Host implementation of the libBAG stand-in, see libBAG.h
+*/
+#include <fcntl.h>
+#include <png.h>
+#define BAG_HOST_SHIM
+#include "libBAG.h"
+
+/*==========================================================================
+DSTwo SDK
+==========================================================================*/
+static unsigned short screenBuf[2][2][SCREEN_WIDTH * SCREEN_HEIGHT];
+static int screenPage = 0;
+
+void *up_screen_addr = screenBuf[0][0];
+void *down_screen_addr = screenBuf[1][0];
+
+void ds2_flipScreen(SCREEN_ID screen, int done){
+    //nothing to present to, just swap back buffers like the hardware does
+    screenPage ^= 1;
+    if(screen & UP_SCREEN)
+        up_screen_addr = screenBuf[0][screenPage];
+    if(screen & DOWN_SCREEN)
+        down_screen_addr = screenBuf[1][screenPage];
+}
+
+//timer ticks a second, as on the DSTwo
+#define SYSTIME_HZ 23437
+static unsigned int sysTime = 0;
+
+unsigned int getSysTime(void){
+    return sysTime;
+}
+
+void ds2_setCPUclocklevel(int level){
+}
+
+void ds2_plug_exit(void){
+    exit(0);
+}
+
+/*==========================================================================
+Core
+==========================================================================*/
+__thread Pad_t Pad;
+
+const char *BAG_Host_Root = "_host/sdcard";
+unsigned long BAG_Host_FrameLimit = 0;
+unsigned long BAG_Host_FrameCount = 0;
+unsigned long BAG_Host_TimeScale = 1;
+static int coreFPS = 60;
+
+const short BAG_SinTable[512] = {
+       0,    3,    6,    9,   13,   16,   19,   22,   25,   28,   31,   34,   38,   41,   44,   47,
+      50,   53,   56,   59,   62,   65,   68,   71,   74,   77,   80,   83,   86,   89,   92,   95,
+      98,  101,  104,  107,  109,  112,  115,  118,  121,  123,  126,  129,  132,  134,  137,  140,
+     142,  145,  147,  150,  152,  155,  157,  160,  162,  165,  167,  170,  172,  174,  177,  179,
+     181,  183,  185,  188,  190,  192,  194,  196,  198,  200,  202,  204,  206,  207,  209,  211,
+     213,  215,  216,  218,  220,  221,  223,  224,  226,  227,  229,  230,  231,  233,  234,  235,
+     237,  238,  239,  240,  241,  242,  243,  244,  245,  246,  247,  248,  248,  249,  250,  250,
+     251,  252,  252,  253,  253,  254,  254,  254,  255,  255,  255,  256,  256,  256,  256,  256,
+     256,  256,  256,  256,  256,  256,  255,  255,  255,  254,  254,  254,  253,  253,  252,  252,
+     251,  250,  250,  249,  248,  248,  247,  246,  245,  244,  243,  242,  241,  240,  239,  238,
+     237,  235,  234,  233,  231,  230,  229,  227,  226,  224,  223,  221,  220,  218,  216,  215,
+     213,  211,  209,  207,  206,  204,  202,  200,  198,  196,  194,  192,  190,  188,  185,  183,
+     181,  179,  177,  174,  172,  170,  167,  165,  162,  160,  157,  155,  152,  150,  147,  145,
+     142,  140,  137,  134,  132,  129,  126,  123,  121,  118,  115,  112,  109,  107,  104,  101,
+      98,   95,   92,   89,   86,   83,   80,   77,   74,   71,   68,   65,   62,   59,   56,   53,
+      50,   47,   44,   41,   38,   34,   31,   28,   25,   22,   19,   16,   13,    9,    6,    3,
+       0,   -3,   -6,   -9,  -13,  -16,  -19,  -22,  -25,  -28,  -31,  -34,  -38,  -41,  -44,  -47,
+     -50,  -53,  -56,  -59,  -62,  -65,  -68,  -71,  -74,  -77,  -80,  -83,  -86,  -89,  -92,  -95,
+     -98, -101, -104, -107, -109, -112, -115, -118, -121, -123, -126, -129, -132, -134, -137, -140,
+    -142, -145, -147, -150, -152, -155, -157, -160, -162, -165, -167, -170, -172, -174, -177, -179,
+    -181, -183, -185, -188, -190, -192, -194, -196, -198, -200, -202, -204, -206, -207, -209, -211,
+    -213, -215, -216, -218, -220, -221, -223, -224, -226, -227, -229, -230, -231, -233, -234, -235,
+    -237, -238, -239, -240, -241, -242, -243, -244, -245, -246, -247, -248, -248, -249, -250, -250,
+    -251, -252, -252, -253, -253, -254, -254, -254, -255, -255, -255, -256, -256, -256, -256, -256,
+    -256, -256, -256, -256, -256, -256, -255, -255, -255, -254, -254, -254, -253, -253, -252, -252,
+    -251, -250, -250, -249, -248, -248, -247, -246, -245, -244, -243, -242, -241, -240, -239, -238,
+    -237, -235, -234, -233, -231, -230, -229, -227, -226, -224, -223, -221, -220, -218, -216, -215,
+    -213, -211, -209, -207, -206, -204, -202, -200, -198, -196, -194, -192, -190, -188, -185, -183,
+    -181, -179, -177, -174, -172, -170, -167, -165, -162, -160, -157, -155, -152, -150, -147, -145,
+    -142, -140, -137, -134, -132, -129, -126, -123, -121, -118, -115, -112, -109, -107, -104, -101,
+     -98,  -95,  -92,  -89,  -86,  -83,  -80,  -77,  -74,  -71,  -68,  -65,  -62,  -59,  -56,  -53,
+     -50,  -47,  -44,  -41,  -38,  -34,  -31,  -28,  -25,  -22,  -19,  -16,  -13,   -9,   -6,   -3,
+};
+
+int BAG_Init(int fat){
+    memset(&Pad, 0, sizeof(Pad));
+    return 1;
+}
+
+void BAG_Core_SetFPS(int fps){
+    //headless, frames are never throttled, the rate only sets how far the timer moves per frame
+    if(fps > 0)
+        coreFPS = fps;
+}
+
+void BAG_Update(void){
+    //game time runs at exactly the frame rate, however long the frame really took
+    sysTime += BAG_Host_TimeScale * (SYSTIME_HZ / coreFPS);
+    BAG_Host_FrameCount++;
+    if(BAG_Host_FrameLimit && BAG_Host_FrameCount >= BAG_Host_FrameLimit)
+        ds2_plug_exit();
+
+    BAG_Host_UpdateInput(BAG_Host_FrameCount);
+}
+
+const char *BAG_Host_Path(const char *path, char *out, size_t size){
+    if(path[0] == '/')
+        snprintf(out, size, "%s%s", BAG_Host_Root, path);
+    else
+        snprintf(out, size, "%s", path);
+    return out;
+}
+
+FILE *BAG_Host_fopen(const char *file, const char *mode){
+    char path[MAX_PATH];
+    return fopen(BAG_Host_Path(file, path, sizeof(path)), mode);
+}
+
+unsigned long BAG_Filesystem_GetFileSize(const char *file){
+    char path[MAX_PATH];
+    struct stat st;
+    if(stat(BAG_Host_Path(file, path, sizeof(path)), &st) < 0)
+        return 0;
+    return st.st_size;
+}
+
+/*==========================================================================
+Graphics
+==========================================================================*/
+int BAG_Display_CreateObj(GFXObj_t *obj, int bpp, int wd, int ht, int frameWd, int frameHt){
+    memset(obj, 0, sizeof(GFXObj_t));
+    obj->buffer = calloc(wd * ht, sizeof(unsigned short));
+    if(obj->buffer == NULL)
+        return ERR_NOMEM;
+
+    obj->bpp = bpp;
+    obj->width = wd;
+    obj->height = ht;
+    obj->frameWd = frameWd;
+    obj->frameHt = frameHt;
+    return NO_ERR;
+}
+
+static int loadPNG(const char *file, GFXObj_t *obj){
+    png_image img;
+    memset(&img, 0, sizeof(img));
+    img.version = PNG_IMAGE_VERSION;
+    if(!png_image_begin_read_from_file(&img, file))
+        return ERR_NOFILE;
+
+    img.format = PNG_FORMAT_RGBA;
+    unsigned char *rgba = malloc(PNG_IMAGE_SIZE(img));
+    if(rgba == NULL){
+        png_image_free(&img);
+        return ERR_NOMEM;
+    }
+    if(!png_image_finish_read(&img, NULL, rgba, 0, NULL)){
+        free(rgba);
+        return ERR_FORMAT;
+    }
+
+    int err = BAG_Display_CreateObj(obj, 16, img.width, img.height, img.width, img.height);
+    if(err == NO_ERR){
+        unsigned char *src = rgba;
+        for(unsigned int i = 0; i < img.width * img.height; i++, src += 4){
+            if(src[3] < 128)
+                obj->buffer[i] = BAG_TRANS_COLOR;
+            else
+                obj->buffer[i] = RGB15(src[0]>>3, src[1]>>3, src[2]>>3);
+        }
+    }
+    free(rgba);
+    return err;
+}
+
+int BAG_Display_LoadObjExt(const char *file, GFXObj_t *obj){
+    char path[MAX_PATH], ext[MAX_PATH + 8];
+    BAG_Host_Path(file, path, sizeof(path));
+
+    //files are given without an extension
+    snprintf(ext, sizeof(ext), "%s.png", path);
+    if(loadPNG(ext, obj) == NO_ERR)
+        return NO_ERR;
+    return loadPNG(path, obj);
+}
+
+void BAG_Display_DeleteObj(GFXObj_t *obj){
+    if(obj->buffer)
+        free(obj->buffer);
+    memset(obj, 0, sizeof(GFXObj_t));
+}
+
+unsigned short *BAG_Display_GetGfxBuf(GFXObj_t *obj){
+    return obj->buffer;
+}
+
+int *BAG_Display_GetGfxWidth(GFXObj_t *obj){
+    return &obj->width;
+}
+
+int *BAG_Display_GetGfxHeight(GFXObj_t *obj){
+    return &obj->height;
+}
+
+int *BAG_Display_GetGfxFrameWd(GFXObj_t *obj){
+    return &obj->frameWd;
+}
+
+int *BAG_Display_GetGfxFrameHt(GFXObj_t *obj){
+    return &obj->frameHt;
+}
+
+int *BAG_Display_GetGfxBlitX(GFXObj_t *obj){
+    return &obj->blitX;
+}
+
+int *BAG_Display_GetGfxBlitY(GFXObj_t *obj){
+    return &obj->blitY;
+}
+
+int *BAG_Display_GetGfxOffsetX(GFXObj_t *obj){
+    return &obj->offsetX;
+}
+
+int *BAG_Display_GetGfxOffsetY(GFXObj_t *obj){
+    return &obj->offsetY;
+}
+
+void BAG_Display_SetGfxBlitXY(GFXObj_t *obj, int x, int y){
+    obj->blitX = x;
+    obj->blitY = y;
+}
+
+void BAG_Display_SetGfxFrameDim(GFXObj_t *obj, int wd, int ht){
+    obj->frameWd = wd;
+    obj->frameHt = ht;
+}
+
+void BAG_Display_SetObjFrame(GFXObj_t *obj, FRAME_DIRECTION dir, int frame){
+    if(dir == FRAME_HOR)
+        obj->frameX = frame;
+    else
+        obj->frameY = frame;
+}
+
+void BAG_Display_StartAnim(GFXObj_t *obj){
+    obj->animating = 1;
+}
+
+void BAG_Display_StopAnim(GFXObj_t *obj){
+    obj->animating = 0;
+}
+
+void BAG_Display_UpdateAnim(GFXObj_t *obj, int firstFrame, int lastFrame, int speed, int frames, FRAME_DIRECTION dir){
+    if(!obj->animating || frames <= 0)
+        return;
+
+    int *cur = (dir == FRAME_HOR) ? &obj->frameX : &obj->frameY;
+    if(*cur < firstFrame || *cur > lastFrame)
+        *cur = firstFrame;
+
+    obj->animTimer += speed;
+    while(obj->animTimer >= frames){
+        obj->animTimer -= frames;
+        if(++(*cur) > lastFrame)
+            *cur = firstFrame;
+    }
+}
+
+//clip the current frame of obj at x,y against a destWd x destHt buffer
+//returns 0 if nothing is visible
+static int clipFrame(GFXObj_t *obj, int x, int y, int destWd, int destHt,
+                     int *srcX, int *srcY, int *dstX, int *dstY, int *wd, int *ht){
+    if(obj->buffer == NULL)
+        return 0;
+
+    *srcX = obj->offsetX + obj->frameX * obj->frameWd;
+    *srcY = obj->offsetY + obj->frameY * obj->frameHt;
+    *wd = obj->frameWd;
+    *ht = obj->frameHt;
+    *dstX = x;
+    *dstY = y;
+
+    //keep source inside the sheet
+    if(*srcX + *wd > obj->width)
+        *wd = obj->width - *srcX;
+    if(*srcY + *ht > obj->height)
+        *ht = obj->height - *srcY;
+
+    if(*dstX < 0){
+        *wd += *dstX;
+        *srcX -= *dstX;
+        *dstX = 0;
+    }
+    if(*dstY < 0){
+        *ht += *dstY;
+        *srcY -= *dstY;
+        *dstY = 0;
+    }
+    if(*dstX + *wd > destWd)
+        *wd = destWd - *dstX;
+    if(*dstY + *ht > destHt)
+        *ht = destHt - *dstY;
+
+    return (*wd > 0 && *ht > 0);
+}
+
+void BAG_Display_DrawObjFast(GFXObj_t *obj, unsigned short *dest, int x, int y){
+    int srcX, srcY, dstX, dstY, wd, ht;
+    if(!clipFrame(obj, x, y, SCREEN_WIDTH, SCREEN_HEIGHT, &srcX, &srcY, &dstX, &dstY, &wd, &ht))
+        return;
+
+    for(int i = 0; i < ht; i++)
+        memcpy(&dest[(dstY + i) * SCREEN_WIDTH + dstX], &obj->buffer[(srcY + i) * obj->width + srcX], wd << 1);
+}
+
+void BAG_Display_DrawObjFastEx(GFXObj_t *obj, unsigned short *dest, int destWd, int destHt){
+    int srcX, srcY, dstX, dstY, wd, ht;
+    if(!clipFrame(obj, obj->blitX, obj->blitY, destWd, destHt, &srcX, &srcY, &dstX, &dstY, &wd, &ht))
+        return;
+
+    for(int i = 0; i < ht; i++)
+        memcpy(&dest[(dstY + i) * destWd + dstX], &obj->buffer[(srcY + i) * obj->width + srcX], wd << 1);
+}
+
+void BAG_Display_DrawObjSlowEx(GFXObj_t *obj, unsigned short *dest, int destWd, int destHt){
+    int srcX, srcY, dstX, dstY, wd, ht;
+    if(!clipFrame(obj, obj->blitX, obj->blitY, destWd, destHt, &srcX, &srcY, &dstX, &dstY, &wd, &ht))
+        return;
+
+    for(int i = 0; i < ht; i++){
+        unsigned short *src = &obj->buffer[(srcY + i) * obj->width + srcX];
+        unsigned short *dst = &dest[(dstY + i) * destWd + dstX];
+        for(int j = 0; j < wd; j++){
+            if(src[j] != BAG_TRANS_COLOR)
+                dst[j] = src[j];
+        }
+    }
+}
+
+static void writeScreenPPM(FILE *file, unsigned short *buf){
+    for(int i = 0; i < SCREEN_WIDTH * SCREEN_HEIGHT; i++){
+        unsigned char rgb[3] = {
+            (buf[i] & 31) << 3, ((buf[i] >> 5) & 31) << 3, ((buf[i] >> 10) & 31) << 3,
+        };
+        fwrite(rgb, 1, 3, file);
+    }
+}
+
+int BAG_Display_ScrnCap(SCREEN_ID screen, const char *dir){
+    static int capNum = 0;
+    char name[MAX_PATH], path[MAX_PATH];
+    snprintf(name, sizeof(name), "%sscrn_%04d.ppm", dir, capNum++);
+    BAG_Host_Path(name, path, sizeof(path));
+
+    FILE *file = fopen(path, "wb");
+    if(file == NULL)
+        return ERR_NOFILE;
+
+    //the last flipped page is what is on screen
+    int shown = screenPage ^ 1;
+    int screens = ((screen & UP_SCREEN) ? 1 : 0) + ((screen & DOWN_SCREEN) ? 1 : 0);
+    fprintf(file, "P6\n%d %d\n255\n", SCREEN_WIDTH, SCREEN_HEIGHT * screens);
+    if(screen & UP_SCREEN)
+        writeScreenPPM(file, screenBuf[0][shown]);
+    if(screen & DOWN_SCREEN)
+        writeScreenPPM(file, screenBuf[1][shown]);
+    fclose(file);
+    return NO_ERR;
+}
+
+/*==========================================================================
+Tiled backgrounds
+==========================================================================*/
+static int getShift(int value){
+    int shift = 0;
+    while((1 << shift) < value)
+        shift++;
+    return shift;
+}
+
+int BAG_TileBG_LoadBG(const char *tileSet, const char *map, TiledBG_t *bg){
+    char path[MAX_PATH];
+    struct{
+        unsigned int width, height;
+        unsigned short tileWd, tileHt;
+    }header;
+
+    memset(bg, 0, sizeof(TiledBG_t));
+    if(BAG_Display_LoadObjExt(tileSet, &bg->tileSet) != NO_ERR)
+        return 0;
+
+    FILE *file = fopen(BAG_Host_Path(map, path, sizeof(path)), "rb");
+    if(file == NULL)
+        goto FAIL;
+    if(fread(&header, 12, 1, file) != 1)
+        goto FAIL_FILE;
+
+    bg->map = malloc(header.width * header.height * sizeof(unsigned int));
+    if(bg->map == NULL)
+        goto FAIL_FILE;
+    if(fread(bg->map, sizeof(unsigned int), header.width * header.height, file) != header.width * header.height)
+        goto FAIL_FILE;
+    fclose(file);
+
+    bg->width = header.width;
+    bg->height = header.height;
+    bg->tileWd = header.tileWd;
+    bg->tileHt = header.tileHt;
+    bg->divX = getShift(bg->tileWd);
+    bg->divY = getShift(bg->tileHt);
+    BAG_Display_SetGfxFrameDim(&bg->tileSet, bg->tileWd, bg->tileHt);
+    return 1;
+
+    FAIL_FILE:
+        fclose(file);
+    FAIL:
+        BAG_TileBG_DeleteBG(bg);
+        return 0;
+}
+
+void BAG_TileBG_DeleteBG(TiledBG_t *bg){
+    BAG_Display_DeleteObj(&bg->tileSet);
+    if(bg->map)
+        free(bg->map);
+    memset(bg, 0, sizeof(TiledBG_t));
+}
+
+void BAG_TileBG_SetProperties(TiledBG_t *bg, int scrnHt, int scrnWd, int scrollX, int scrollY){
+    bg->scrnHt = scrnHt;
+    bg->scrnWd = scrnWd;
+    bg->scrollX = scrollX;
+    bg->scrollY = scrollY;
+}
+
+int BAG_TileBG_GetTile(TiledBG_t *bg, int x, int y){
+    if(x < 0 || y < 0 || x >= bg->width || y >= bg->height)
+        return 0;
+    return bg->map[y * bg->width + x];
+}
+
+//x and y are in pixels relative to the backgrounds origin
+unsigned int *BAG_TileBG_SetTile_GetTilePixAddr(TiledBG_t *bg, int x, int y){
+    if(x < 0 || y < 0)
+        return NULL;
+    x >>= bg->divX;
+    y >>= bg->divY;
+    if(x >= bg->width || y >= bg->height)
+        return NULL;
+    return &bg->map[y * bg->width + x];
+}
+
+void BAG_TileBG_DrawBGEx(unsigned short *dest, TiledBG_t *bg, int x, int y, int destWd, int destHt){
+    GFXObj_t *tiles = &bg->tileSet;
+    for(int ty = 0; ty < bg->height; ty++){
+        for(int tx = 0; tx < bg->width; tx++){
+            unsigned int tile = bg->map[ty * bg->width + tx];
+            if(tile == 0)
+                continue;
+            //tile ids start at 1, 0 is empty
+            BAG_Display_SetObjFrame(tiles, FRAME_HOR, tile - 1);
+            BAG_Display_SetGfxBlitXY(tiles, x + (tx << bg->divX), y + (ty << bg->divY));
+            BAG_Display_DrawObjSlowEx(tiles, dest, destWd, destHt);
+        }
+    }
+}
+
+/*==========================================================================
+FAT helpers
+==========================================================================*/
+dirent *readdir_ex(DIR *dir, struct stat *st){
+    dirent *entry = readdir(dir);
+    if(entry != NULL && st != NULL)
+        fstatat(dirfd(dir), entry->d_name, st, AT_SYMLINK_NOFOLLOW);
+    return entry;
+}
+
+int fat_setHidden(const char *file, unsigned char hide){
+    return 0;
+}
+
+int fat_isHidden(struct stat *st){
+    return 0;
+}
@@ -0,0 +1,212 @@
+/*
+*Minimal libBAG stand-in for building the game natively on a linux host.
+*Only the parts of libBAG and the DSTwo SDK used by the sources in src/ are
+*provided. Everything renders into plain 16bit framebuffers in memory, there
+*is no window, sound or real input.
+*/
+#ifndef _LIBBAG_HOST_H_
+#define _LIBBAG_HOST_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BAG_HOST_BUILD
+
+typedef unsigned char u8;
+typedef unsigned short u16;
+typedef unsigned int u32;
+typedef signed char s8;
+typedef signed short s16;
+typedef signed int s32;
+
+#ifndef MAX_PATH
+    #define MAX_PATH 512
+#endif
+
+#define SET_FLAG(var, flag) ((var) |= (flag))
+#define GET_FLAG(var, flag) ((var) & (flag))
+#define RESET_FLAG(var, flag) ((var) &= ~(flag))
+
+/*==========================================================================
+DSTwo SDK
+==========================================================================*/
+#define SCREEN_WIDTH 256
+#define SCREEN_HEIGHT 192
+
+typedef enum{
+    UP_SCREEN = 1,
+    DOWN_SCREEN = 2,
+    DUAL_SCREEN = 3,
+}SCREEN_ID;
+
+//back buffers of each screen, swapped on every ds2_flipScreen
+extern void *up_screen_addr, *down_screen_addr;
+
+extern void ds2_flipScreen(SCREEN_ID screen, int done);
+//system timer in ticks of 42.667us, on the host it only moves on in BAG_Update
+extern unsigned int getSysTime(void);
+extern void ds2_setCPUclocklevel(int level);
+extern void ds2_plug_exit(void);
+//the game provides this, host main() calls it
+extern void ds2_main(void);
+
+/*==========================================================================
+Colors
+==========================================================================*/
+#define RGB15(r,g,b) ((r)|((g)<<5)|((b)<<10))
+//magenta is treated as transparent by the slow blitters
+#define BAG_TRANS_COLOR RGB15(31,0,31)
+
+/*==========================================================================
+Core
+==========================================================================*/
+typedef enum{
+    NO_ERR = 0,
+    ERR_NOFILE,
+    ERR_NOMEM,
+    ERR_FORMAT,
+}BAG_ERRORS;
+
+typedef struct PadButtons_t{
+    unsigned int A:1, B:1, X:1, Y:1,
+                 L:1, R:1, Start:1, Select:1,
+                 Up:1, Down:1, Left:1, Right:1,
+                 Touch:1;
+}PadButtons_t;
+
+typedef struct Pad_t{
+    PadButtons_t Held, Newpress, Released;
+}Pad_t;
+
+//one per thread, so headless games on several threads each have their own
+extern __thread Pad_t Pad;
+
+extern int BAG_Init(int fat);
+extern void BAG_Core_SetFPS(int fps);
+extern void BAG_Update(void);
+
+//sin and cos over 512 steps per circle, 8 bits of fraction
+extern const short BAG_SinTable[512];
+#define BAG_Sin(angle) (BAG_SinTable[(angle)&511])
+#define BAG_Cos(angle) (BAG_SinTable[((angle) + 128)&511])
+
+extern unsigned long BAG_Filesystem_GetFileSize(const char *file);
+
+/*==========================================================================
+Graphics
+==========================================================================*/
+typedef enum{
+    FRAME_HOR,
+    FRAME_VERT,
+}FRAME_DIRECTION;
+
+typedef struct GFXObj_t{
+    unsigned short *buffer;
+    int width, height;//full sheet dimensions
+    int frameWd, frameHt;
+    int frameX, frameY;//current frame in each direction
+    int offsetX, offsetY;//pixel offset of frame 0 in the sheet
+    int blitX, blitY;
+    int animTimer, animating;
+    char bpp;
+}GFXObj_t;
+
+extern int BAG_Display_CreateObj(GFXObj_t *obj, int bpp, int wd, int ht, int frameWd, int frameHt);
+extern int BAG_Display_LoadObjExt(const char *file, GFXObj_t *obj);
+extern void BAG_Display_DeleteObj(GFXObj_t *obj);
+
+extern unsigned short *BAG_Display_GetGfxBuf(GFXObj_t *obj);
+extern int *BAG_Display_GetGfxWidth(GFXObj_t *obj);
+extern int *BAG_Display_GetGfxHeight(GFXObj_t *obj);
+extern int *BAG_Display_GetGfxFrameWd(GFXObj_t *obj);
+extern int *BAG_Display_GetGfxFrameHt(GFXObj_t *obj);
+extern int *BAG_Display_GetGfxBlitX(GFXObj_t *obj);
+extern int *BAG_Display_GetGfxBlitY(GFXObj_t *obj);
+extern int *BAG_Display_GetGfxOffsetX(GFXObj_t *obj);
+extern int *BAG_Display_GetGfxOffsetY(GFXObj_t *obj);
+
+extern void BAG_Display_SetGfxBlitXY(GFXObj_t *obj, int x, int y);
+extern void BAG_Display_SetGfxFrameDim(GFXObj_t *obj, int wd, int ht);
+extern void BAG_Display_SetObjFrame(GFXObj_t *obj, FRAME_DIRECTION dir, int frame);
+
+extern void BAG_Display_StartAnim(GFXObj_t *obj);
+extern void BAG_Display_StopAnim(GFXObj_t *obj);
+extern void BAG_Display_UpdateAnim(GFXObj_t *obj, int firstFrame, int lastFrame, int speed, int frames, FRAME_DIRECTION dir);
+
+//opaque copy of the current frame to a screen sized buffer
+extern void BAG_Display_DrawObjFast(GFXObj_t *obj, unsigned short *dest, int x, int y);
+//opaque copy of the current frame at its blit position, clipped to dest
+extern void BAG_Display_DrawObjFastEx(GFXObj_t *obj, unsigned short *dest, int destWd, int destHt);
+//color keyed copy of the current frame at its blit position, clipped to dest
+extern void BAG_Display_DrawObjSlowEx(GFXObj_t *obj, unsigned short *dest, int destWd, int destHt);
+
+extern int BAG_Display_ScrnCap(SCREEN_ID screen, const char *dir);
+
+/*==========================================================================
+Tiled backgrounds
+==========================================================================*/
+typedef struct TiledBG_t{
+    GFXObj_t tileSet;
+    unsigned int *map;
+    int width, height;//in tiles
+    int tileWd, tileHt;
+    int divX, divY;//shifts for tile dimensions
+    int scrnWd, scrnHt;//visible tiles
+    int scrollX, scrollY;
+}TiledBG_t;
+
+extern int BAG_TileBG_LoadBG(const char *tileSet, const char *map, TiledBG_t *bg);
+extern void BAG_TileBG_DeleteBG(TiledBG_t *bg);
+extern void BAG_TileBG_SetProperties(TiledBG_t *bg, int scrnHt, int scrnWd, int scrollX, int scrollY);
+extern int BAG_TileBG_GetTile(TiledBG_t *bg, int x, int y);
+extern unsigned int *BAG_TileBG_SetTile_GetTilePixAddr(TiledBG_t *bg, int x, int y);
+extern void BAG_TileBG_DrawBGEx(unsigned short *dest, TiledBG_t *bg, int x, int y, int destWd, int destHt);
+
+/*==========================================================================
+FAT helpers
+==========================================================================*/
+typedef struct dirent dirent;
+
+extern dirent *readdir_ex(DIR *dir, struct stat *st);
+extern int fat_setHidden(const char *file, unsigned char hide);
+extern int fat_isHidden(struct stat *st);
+
+/*==========================================================================
+Host only
+==========================================================================*/
+//directory that stands in for the root of the sd card
+extern const char *BAG_Host_Root;
+//stop after this many BAG_Update calls, 0 runs forever
+extern unsigned long BAG_Host_FrameLimit;
+extern unsigned long BAG_Host_FrameCount;
+//frames of game time that pass per BAG_Update, at the rate given to BAG_Core_SetFPS
+extern unsigned long BAG_Host_TimeScale;
+
+//map an sd card path to the host file system
+extern const char *BAG_Host_Path(const char *path, char *out, size_t size);
+//fopen for sd card paths, the game's own fopen calls are routed here
+extern FILE *BAG_Host_fopen(const char *file, const char *mode);
+#ifndef BAG_HOST_SHIM
+    #define fopen(file, mode) BAG_Host_fopen(file, mode)
+#endif
+
+//scripted input, see input.c
+extern int BAG_Host_LoadInput(const char *file);
+extern void BAG_Host_UpdateInput(unsigned long frame);
+extern void BAG_Host_SetPad(unsigned int held);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,118 @@
+/*
+*Host entry point, sets up the libBAG stand-in and runs the game's ds2_main
+*/
+#include <getopt.h>
+#define BAG_HOST_SHIM
+#include "libBAG.h"
+#include "profile.h"
+#include "blit.h"
+#include "simClock.h"
+#include "game.h"
+
+#define BENCH_DEFAULT_FRAMES 10000
+
+static const char *RecordFile;
+
+static void captureOnExit(void){
+    BAG_Display_ScrnCap(DUAL_SCREEN, "/");
+}
+
+static void saveRecording(void){
+    if(Game_SaveRecording(RecordFile))
+        printf("recorded %lu steps to %s\n", Game_Recorded(), RecordFile);
+    else
+        printf("error saving recording %s\n", RecordFile);
+}
+
+static void replayReport(void){
+    unsigned long mismatches, first;
+    unsigned long steps = Game_ReplayResult(&mismatches, &first);
+    if(mismatches)
+        printf("replay: %lu steps, %lu differ from the recording, first at step %lu\n", steps, mismatches, first);
+    else
+        printf("replay: %lu steps, every state matches the recording\n", steps);
+}
+
+static void usage(const char *name){
+    printf("usage: %s [-r sdcard root] [-n frames] [-i input script] [-R file] [-P file] [-k kernels] [-s scale] [-b] [-c]\n", name);
+    printf("  -r  directory used as the root of the sd card (default %s)\n", BAG_Host_Root);
+    printf("  -n  exit after this many frames, 0 runs forever (default 0)\n");
+    printf("  -i  feed the pad from a script, see host/input.c\n");
+    printf("  -R  record every step's pad and game state hash to a file on exit\n");
+    printf("  -P  play back a recording instead of the pad, exits at its end and reports any state that differs\n");
+    printf("  -k  blit kernels to use, c, sse2 or avx2 (default the fastest the cpu runs)\n");
+    printf("  -s  game steps per drawn frame, runs faster than real time (default 1, at most %d)\n", SIM_MAX_STEPS);
+    printf("  -b  benchmark, report per phase frame times on exit (default %d frames)\n", BENCH_DEFAULT_FRAMES);
+    printf("  -c  save a capture of both screens to the sd card root on exit\n");
+}
+
+int main(int argc, char *argv[]){
+    int opt, bench = 0;
+    const char *kernels = NULL;
+    while((opt = getopt(argc, argv, "r:n:i:R:P:k:s:bch")) != -1){
+        switch(opt){
+            case 'r':
+                BAG_Host_Root = optarg;
+            break;
+            case 'n':
+                BAG_Host_FrameLimit = strtoul(optarg, NULL, 10);
+            break;
+            case 'i':
+                if(!BAG_Host_LoadInput(optarg)){
+                    printf("error loading input script %s\n", optarg);
+                    return 1;
+                }
+            break;
+            case 'R':
+                RecordFile = optarg;
+                Game_Record();
+                atexit(&saveRecording);
+            break;
+            case 'P':
+                if(!Game_Replay(optarg)){
+                    printf("error loading replay %s\n", optarg);
+                    return 1;
+                }
+                atexit(&replayReport);
+            break;
+            case 'k':
+                kernels = optarg;
+            break;
+            case 's':
+                BAG_Host_TimeScale = strtoul(optarg, NULL, 10);
+                if(BAG_Host_TimeScale < 1 || BAG_Host_TimeScale > SIM_MAX_STEPS){
+                    printf("scale must be 1 to %d\n", SIM_MAX_STEPS);
+                    return 1;
+                }
+            break;
+            case 'b':
+                bench = 1;
+            break;
+            case 'c':
+                atexit(&captureOnExit);
+            break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if(!Blit_Init(kernels)){
+        printf("no %s blit kernels on this cpu\n", kernels);
+        return 1;
+    }
+    printf("blit kernels: %s\n", Blit.name);
+
+    if(bench){
+        if(!BAG_Host_FrameLimit)
+            BAG_Host_FrameLimit = BENCH_DEFAULT_FRAMES;
+        if(!Profile_Init(BAG_Host_FrameLimit)){
+            printf("error allocating profile samples\n");
+            return 1;
+        }
+        atexit(&Profile_Report);
+    }
+
+    ds2_main();
+    return 0;
+}
@@ -0,0 +1,235 @@
+/*
+*Headless batch simulator, plays whole games of the first level with no
+*drawing at all, one game per thread at a time across every core, and reports
+*how each went. The game logic is the same code the device runs, stepped as
+*fast as the cpu allows instead of at the fixed 120 steps a second.
+*
+*Without an input script the pad is driven by a simple player that follows
+*the ball and aims its bounces at random. Each game seeds its own player, so
+*the results do not depend on how many threads play them.
+*/
+#include <getopt.h>
+#include <pthread.h>
+#include <time.h>
+#define BAG_HOST_SHIM
+#include "libBAG.h"
+#include "quick2dEngine.h"
+#include "game.h"
+#include "simClock.h"
+
+#define BATCH_DEFAULT_GAMES 64
+//half an hour of game time, a game still going by then is cut off
+#define BATCH_DEFAULT_STEPS (SIM_HZ * 60 * 30)
+
+//bits of the BAG_Host_SetPad mask, see host/input.c
+#define PAD_A (1 << 0)
+#define PAD_LEFT (1 << 10)
+#define PAD_RIGHT (1 << 11)
+
+typedef struct BatchGame_t{
+    GameStats_t stats;
+    char ok;//played, the thread could load the game
+}BatchGame_t;
+
+static const char *Skin = "default", *Level = "level_1.lvl";
+static int Games = BATCH_DEFAULT_GAMES, Scripted = 0;
+static unsigned long MaxSteps = BATCH_DEFAULT_STEPS;
+static unsigned int Seed = 1;
+static BatchGame_t *Results;
+static int NextGame = 0;
+
+typedef struct AutoPlayer_t{
+    unsigned int seed;
+    int aim;//where on the paddle to catch the ball, from its centre
+    int wait;//steps to wander before launching
+    int lastY;
+    char falling;
+}AutoPlayer_t;
+
+static void autoStart(AutoPlayer_t *ap, unsigned int seed){
+    ap->seed = seed;
+    ap->aim = 0;
+    ap->wait = rand_r(&ap->seed) % SIM_HZ;
+    ap->lastY = 0;
+    ap->falling = 0;
+}
+
+static unsigned int autoPad(AutoPlayer_t *ap, unsigned long step){
+    GameView_t view;
+    Game_View(&view);
+    int half = view.paddleWd >> 1,
+        ball = view.ballX + (view.ballWd >> 1),
+        paddle = view.paddleX + half;
+
+    if(!view.ballMoving){
+        ap->falling = 0;
+        //the paddle is not stopped at the walls, so wander inside them
+        if(ap->wait > 0 && view.paddleX > half && view.paddleX + view.paddleWd < GAME_WIDTH - half){
+            ap->wait--;
+            return (ap->seed & 1) ? PAD_LEFT : PAD_RIGHT;
+        }
+        //a fresh press every other step, launches only take new presses
+        if(view.ballReady)
+            return (step & 1) ? PAD_A : 0;
+        return 0;
+    }
+
+    //pick a new spot on the paddle each time the ball starts coming down
+    char falling = view.ballY > ap->lastY;
+    if(falling && !ap->falling)
+        ap->aim = (int)(rand_r(&ap->seed) % (2 * half - 2)) - half + 1;
+    ap->falling = falling;
+    ap->lastY = view.ballY;
+
+    int target = ball - ap->aim;
+    if(target < paddle - 2)
+        return PAD_LEFT;
+    if(target > paddle + 2)
+        return PAD_RIGHT;
+    return 0;
+}
+
+static void *batchThread(void *arg){
+    if(!Game_Init(Skin, Level)){
+        Game_Free();
+        return NULL;
+    }
+
+    int game;
+    while((game = __sync_fetch_and_add(&NextGame, 1)) < Games){
+        AutoPlayer_t ap;
+        autoStart(&ap, Seed + game);
+        Game_Restart();
+        BAG_Host_SetPad(0);
+
+        const GameStats_t *stats = Game_Stats();
+        for(unsigned long step = 1; step <= MaxSteps && !stats->levels && !stats->over; step++){
+            if(Scripted)
+                BAG_Host_UpdateInput(step);
+            else
+                BAG_Host_SetPad(autoPad(&ap, step));
+            Game_Step();
+        }
+        Results[game].stats = *stats;
+        Results[game].ok = 1;
+    }
+    Game_Free();
+    return NULL;
+}
+
+static double now(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void usage(const char *name){
+    printf("usage: %s [-r sdcard root] [-g games] [-j threads] [-n steps] [-i input script] [-S seed] [-l level] [-q]\n", name);
+    printf("  -r  directory used as the root of the sd card (default %s)\n", BAG_Host_Root);
+    printf("  -g  games to play (default %d)\n", BATCH_DEFAULT_GAMES);
+    printf("  -j  threads to play them on (default one per core)\n");
+    printf("  -n  steps before a game is cut off (default %d)\n", BATCH_DEFAULT_STEPS);
+    printf("  -i  drive every game from this script instead of the auto player\n");
+    printf("  -S  seed of the first game's auto player (default %u)\n", Seed);
+    printf("  -l  level to play (default %s)\n", Level);
+    printf("  -q  only print the totals\n");
+}
+
+int main(int argc, char *argv[]){
+    int opt, threads = sysconf(_SC_NPROCESSORS_ONLN), quiet = 0;
+    while((opt = getopt(argc, argv, "r:g:j:n:i:S:l:qh")) != -1){
+        switch(opt){
+            case 'r':
+                BAG_Host_Root = optarg;
+            break;
+            case 'g':
+                Games = atoi(optarg);
+            break;
+            case 'j':
+                threads = atoi(optarg);
+            break;
+            case 'n':
+                MaxSteps = strtoul(optarg, NULL, 10);
+            break;
+            case 'i':
+                if(!BAG_Host_LoadInput(optarg)){
+                    printf("error loading input script %s\n", optarg);
+                    return 1;
+                }
+                Scripted = 1;
+            break;
+            case 'S':
+                Seed = strtoul(optarg, NULL, 10);
+            break;
+            case 'l':
+                Level = optarg;
+            break;
+            case 'q':
+                quiet = 1;
+            break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if(Games < 1 || threads < 1 || MaxSteps < 1){
+        usage(argv[0]);
+        return 1;
+    }
+    if(threads > Games)
+        threads = Games;
+
+    BAG_Init(1);
+    Results = calloc(Games, sizeof(BatchGame_t));
+    pthread_t *pool = calloc(threads, sizeof(pthread_t));
+    if(!Results || !pool){
+        printf("out of memory\n");
+        return 1;
+    }
+
+    double start = now();
+    for(int i = 0; i < threads; i++){
+        if(pthread_create(&pool[i], NULL, &batchThread, NULL)){
+            printf("error starting thread %d\n", i);
+            return 1;
+        }
+    }
+    for(int i = 0; i < threads; i++)
+        pthread_join(pool[i], NULL);
+    double elapsed = now() - start;
+
+    unsigned long long steps = 0, clearSteps = 0, bricks = 0, lives = 0;
+    int played = 0, cleared = 0;
+    for(int i = 0; i < Games; i++){
+        BatchGame_t *game = &Results[i];
+        if(!game->ok)
+            continue;
+        const GameStats_t *s = &game->stats;
+        played++;
+        steps += s->steps;
+        bricks += s->bricks;
+        lives += s->livesLost;
+        if(s->clearedAt){
+            cleared++;
+            clearSteps += s->clearedAt;
+        }
+        if(!quiet){
+            printf("game %d: %s after %lu steps, %u bricks, %.2f bricks/s, %u lives lost, score %u\n", i,
+                   s->clearedAt ? "cleared" : (s->over ? "game over" : "cut off"), s->steps,
+                   s->bricks, s->steps ? s->bricks * (double)SIM_HZ / s->steps : 0.0, s->livesLost, s->score);
+        }
+    }
+    if(played < Games){
+        printf("error loading the game, %d of %d games played\n", played, Games);
+        return 1;
+    }
+
+    printf("%d games on %d threads in %.3f s, %.1f games/s, %.0f steps/s (%.0fx real time)\n",
+           played, threads, elapsed, played / elapsed, steps / elapsed, steps / elapsed / SIM_HZ);
+    printf("cleared %d, average %.0f steps to clear, %.2f bricks/s, %.2f lives lost a game\n",
+           cleared, cleared ? (double)clearSteps / cleared : 0.0,
+           steps ? bricks * (double)SIM_HZ / steps : 0.0, (double)lives / played);
+    free(pool);
+    free(Results);
+    return 0;
+}
@@ -0,0 +1,348 @@
+/*
+*Level compiler, turns Tiled .tmx maps (and old .tbag levels) into the game's
+*.lvl format, see src/levelMap.h for the layout. Tile ids are checked against
+*the brick sheet and the level's LevelInfo_t is counted here, so the DS never
+*parses xml or inflates anything. Built with src/levelMap.c, which reads the
+*result back to check it.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <zlib.h>
+#include "levelMap.h"
+
+typedef struct Level{
+    int width, height, tileWd, tileHt;
+    unsigned char *tiles;
+}Level;
+
+static unsigned char *readFile(const char *file, unsigned long *size){
+    FILE *fp = fopen(file, "rb");
+    if(!fp)
+        return NULL;
+
+    fseek(fp, 0, SEEK_END);
+    *size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    //zero terminated so xml can be searched as a string
+    unsigned char *data = malloc(*size + 1);
+    if(data && fread(data, 1, *size, fp) != *size){
+        free(data);
+        data = NULL;
+    }
+    if(data)
+        data[*size] = '\0';
+    fclose(fp);
+    return data;
+}
+
+//tile ids above a byte do not exist in the brick sheet, they load as empty
+static unsigned char narrow(unsigned int tile){
+    return tile > 255 ? 0 : tile;
+}
+
+static int loadTbag(Level *level, const unsigned char *data, unsigned long size){
+    if(size < 12)
+        return 0;
+    level->width = data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24);
+    level->height = data[4] | (data[5] << 8) | (data[6] << 16) | (data[7] << 24);
+    level->tileWd = data[8] | (data[9] << 8);
+    level->tileHt = data[10] | (data[11] << 8);
+
+    unsigned long count = (unsigned long)level->width * level->height;
+    if(12 + count * 4 > size || !(level->tiles = malloc(count)))
+        return 0;
+    for(unsigned long i = 0; i < count; i++){
+        const unsigned char *src = &data[12 + i * 4];
+        level->tiles[i] = narrow(src[0] | (src[1] << 8) | (src[2] << 16) | ((unsigned int)src[3] << 24));
+    }
+    return 1;
+}
+
+//integer value of attr="..." inside the first tag starting at tag
+static int xmlAttr(const char *xml, const char *tag, const char *attr, int *value){
+    const char *start = strstr(xml, tag);
+    if(!start)
+        return 0;
+    const char *end = strchr(start, '>');
+
+    char key[64];
+    snprintf(key, sizeof(key), " %s=\"", attr);
+    const char *found = strstr(start, key);
+    if(!found || (end && found > end))
+        return 0;
+    *value = atoi(found + strlen(key));
+    return 1;
+}
+
+static int base64Value(char c){
+    if(c >= 'A' && c <= 'Z') return c - 'A';
+    if(c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if(c >= '0' && c <= '9') return c - '0' + 52;
+    if(c == '+') return 62;
+    if(c == '/') return 63;
+    return -1;
+}
+
+static unsigned long base64Decode(const char *src, const char *end, unsigned char *out){
+    unsigned long len = 0;
+    unsigned int bits = 0;
+    int count = 0;
+    for(; src < end && *src != '='; src++){
+        int value = base64Value(*src);
+        if(value < 0)
+            continue;
+        bits = (bits << 6) | value;
+        if(++count == 4){
+            out[len++] = bits >> 16;
+            out[len++] = bits >> 8;
+            out[len++] = bits;
+            bits = count = 0;
+        }
+    }
+    if(count == 3){
+        out[len++] = bits >> 10;
+        out[len++] = bits >> 2;
+    }
+    else if(count == 2)
+        out[len++] = bits >> 4;
+    return len;
+}
+
+//only the first layer is converted, base64 data either raw or zlib compressed
+static int loadTmx(Level *level, const char *xml){
+    int firstGid = 1;
+    if(!xmlAttr(xml, "<map", "width", &level->width) || !xmlAttr(xml, "<map", "height", &level->height) ||
+       !xmlAttr(xml, "<map", "tilewidth", &level->tileWd) || !xmlAttr(xml, "<map", "tileheight", &level->tileHt))
+        return 0;
+    xmlAttr(xml, "<tileset", "firstgid", &firstGid);
+
+    const char *data = strstr(xml, "<data");
+    if(!data || !strstr(data, "encoding=\"base64\"")){
+        printf("only base64 encoded layers are supported\n");
+        return 0;
+    }
+    int compressed = strstr(data, "compression=\"zlib\"") && strstr(data, "compression=\"zlib\"") < strchr(data, '>');
+    const char *start = strchr(data, '>') + 1, *end = strstr(start, "</data>");
+    if(!end)
+        return 0;
+
+    unsigned long count = (unsigned long)level->width * level->height,
+                  rawSize = count * 4;
+    unsigned char *decoded = malloc(end - start), *raw = malloc(rawSize);
+    level->tiles = malloc(count);
+    if(!decoded || !raw || !level->tiles)
+        goto FAIL;
+
+    unsigned long len = base64Decode(start, end, decoded);
+    if(compressed){
+        uLongf outSize = rawSize;
+        if(uncompress(raw, &outSize, decoded, len) != Z_OK || outSize != rawSize)
+            goto FAIL;
+    }
+    else if(len == rawSize)
+        memcpy(raw, decoded, rawSize);
+    else
+        goto FAIL;
+
+    for(unsigned long i = 0; i < count; i++){
+        //top bits of a gid are Tiled's flip flags
+        unsigned int gid = (raw[i * 4] | (raw[i * 4 + 1] << 8) | (raw[i * 4 + 2] << 16) | ((unsigned int)raw[i * 4 + 3] << 24)) & 0x1fffffff;
+        level->tiles[i] = gid ? narrow(gid - firstGid + 1) : 0;
+    }
+    free(decoded);
+    free(raw);
+    return 1;
+
+    FAIL:
+        free(decoded);
+        free(raw);
+        return 0;
+}
+
+static int rowEmpty(const Level *level, int row){
+    for(int i = 0; i < level->width; i++){
+        if(level->tiles[row * level->width + i])
+            return 0;
+    }
+    return 1;
+}
+
+//number of tiles across a png tile sheet, from its IHDR
+static int sheetTiles(const char *file, int tileWd){
+    unsigned long size;
+    unsigned char *data = readFile(file, &size);
+    if(!data)
+        return -1;
+
+    int width = -1;
+    if(size >= 24 && !memcmp(&data[12], "IHDR", 4))
+        width = (data[16] << 24) | (data[17] << 16) | (data[18] << 8) | data[19];
+    free(data);
+    return width < 0 ? -1 : width / tileWd;
+}
+
+//every tile has to be a frame of the sheet
+static int validate(const Level *level, int sheetCount){
+    int bad = 0;
+    for(int i = 0; i < level->width * level->height; i++){
+        if(level->tiles[i] > sheetCount){
+            if(bad++ < 8)
+                printf("tile %d at %d,%d is past the %d tiles of the sheet\n", level->tiles[i],
+                       i % level->width, i / level->width, sheetCount);
+        }
+    }
+    return !bad;
+}
+
+static void put16(unsigned char *dest, int value){
+    dest[0] = value;
+    dest[1] = value >> 8;
+}
+
+static int writeLvl(const Level *level, const char *file, int pack){
+    if(level->width > 0xffff || level->height > 0xffff || level->tileWd > 255 || level->tileHt > 255){
+        printf("level is too big for the format\n");
+        return 0;
+    }
+
+    FILE *fp = fopen(file, "wb");
+    if(!fp)
+        return 0;
+
+    LevelInfo_t info;
+    LevelInfo_Count(&info, level->tiles, level->width, level->height);
+
+    unsigned char header[LEVEL_HEADER_SIZE + 8 + LEVEL_MAX_TYPES * 2] = {0};
+    int headerSize = LEVEL_HEADER_SIZE + 8 + info.types * 2;
+    memcpy(header, LEVEL_MAGIC, 4);
+    header[4] = LEVEL_VERSION;
+    header[5] = LEVEL_HAS_INFO | (pack ? LEVEL_PACKED_ROWS : 0);
+    header[6] = level->tileWd;
+    header[7] = level->tileHt;
+    put16(&header[8], level->width);
+    put16(&header[10], level->height);
+    put16(&header[12], headerSize);
+
+    unsigned char *block = &header[LEVEL_HEADER_SIZE];
+    put16(&block[0], info.bricks);
+    put16(&block[2], info.firstRow);
+    put16(&block[4], info.lastRow);
+    put16(&block[6], info.types);
+    for(int i = 0; i < info.types; i++)
+        put16(&block[8 + i * 2], info.histogram[i]);
+    fwrite(header, headerSize, 1, fp);
+
+    if(!pack)
+        fwrite(level->tiles, 1, level->width * level->height, fp);
+    else{
+        //runs of empty rows followed by runs of rows with bricks
+        int row = 0;
+        while(row < level->height){
+            int empty = 0, stored = 0;
+            while(empty < 255 && row + empty < level->height && rowEmpty(level, row + empty))
+                empty++;
+            row += empty;
+            while(stored < 255 && row + stored < level->height && !rowEmpty(level, row + stored))
+                stored++;
+            fputc(empty, fp);
+            fputc(stored, fp);
+            fwrite(&level->tiles[row * level->width], 1, stored * level->width, fp);
+            row += stored;
+        }
+    }
+    fclose(fp);
+    return 1;
+}
+
+//load the written level the way the game does and make sure it matches
+static int readBack(const Level *level, const char *file, int verbose){
+    LevelMap_t map;
+    if(!LevelMap_Open(&map, file))
+        return 0;
+
+    int ok = map.grid.width == level->width && map.grid.height == level->height &&
+             !memcmp(map.grid.tiles, level->tiles, level->width * level->height);
+    if(ok && verbose){
+        LevelInfo_t *info = &map.info;
+        printf("%s: %dx%d, %d bricks in rows %d-%d, tiles", file, level->width, level->height,
+               info->bricks, info->firstRow, info->lastRow);
+        for(int i = 1; i < info->types; i++){
+            if(info->histogram[i])
+                printf(" %d:%d", i, info->histogram[i]);
+        }
+        printf("\n");
+    }
+    LevelMap_Close(&map);
+    return ok;
+}
+
+static void usage(const char *name){
+    printf("usage: %s [-p] [-s sheet.png] [-v] in.tmx|in.tbag out.lvl\n", name);
+    printf("  -p  pack runs of empty rows\n");
+    printf("  -s  fail on tile ids the brick sheet does not have\n");
+    printf("  -v  print the level's brick count, rows and tile histogram\n");
+}
+
+int main(int argc, char *argv[]){
+    int opt, pack = 0, verbose = 0;
+    const char *sheet = NULL;
+    while((opt = getopt(argc, argv, "ps:vh")) != -1){
+        switch(opt){
+            case 'p':
+                pack = 1;
+            break;
+            case 's':
+                sheet = optarg;
+            break;
+            case 'v':
+                verbose = 1;
+            break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if(argc - optind != 2){
+        usage(argv[0]);
+        return 1;
+    }
+    const char *in = argv[optind], *out = argv[optind + 1];
+
+    unsigned long size;
+    unsigned char *data = readFile(in, &size);
+    if(!data){
+        printf("error reading %s\n", in);
+        return 1;
+    }
+
+    Level level = {0};
+    const char *ext = strrchr(in, '.');
+    int ok = (ext && !strcmp(ext, ".tmx")) ? loadTmx(&level, (const char *)data) : loadTbag(&level, data, size);
+    free(data);
+    if(!ok){
+        printf("error converting %s\n", in);
+        return 1;
+    }
+
+    if(sheet){
+        int count = sheetTiles(sheet, level.tileWd);
+        if(count < 0){
+            printf("error reading tile sheet %s\n", sheet);
+            return 1;
+        }
+        if(!validate(&level, count)){
+            printf("%s does not match %s\n", in, sheet);
+            return 1;
+        }
+    }
+
+    if(!writeLvl(&level, out, pack) || !readBack(&level, out, verbose)){
+        printf("error writing %s\n", out);
+        remove(out);
+        return 1;
+    }
+    free(level.tiles);
+    return 0;
+}
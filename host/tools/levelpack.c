@@ -0,0 +1,125 @@
+/*
+*Level packer, puts level files (.lvl or .tbag) into one pack with an index,
+*see src/levelPack.h for the layout. Levels are named by their file name.
+*Built with src/levelPack.c, which reads the result back to check it.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "levelPack.h"
+
+static unsigned char *readFile(const char *file, unsigned long *size){
+    FILE *fp = fopen(file, "rb");
+    if(!fp)
+        return NULL;
+
+    fseek(fp, 0, SEEK_END);
+    *size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    unsigned char *data = malloc(*size ? *size : 1);
+    if(data && fread(data, 1, *size, fp) != *size){
+        free(data);
+        data = NULL;
+    }
+    fclose(fp);
+    return data;
+}
+
+static void put16(unsigned char *dest, int value){
+    dest[0] = value;
+    dest[1] = value >> 8;
+}
+
+static void put32(unsigned char *dest, unsigned int value){
+    put16(dest, value & 0xffff);
+    put16(&dest[2], value >> 16);
+}
+
+static int writePack(const char *file, char **levels, int count){
+    FILE *fp = fopen(file, "wb");
+    if(!fp)
+        return 0;
+
+    //index first, the levels follow it in the order given
+    unsigned char header[LEVELPACK_HEADER_SIZE];
+    memcpy(header, LEVELPACK_MAGIC, 4);
+    put16(&header[4], LEVELPACK_VERSION);
+    put16(&header[6], count);
+    fwrite(header, LEVELPACK_HEADER_SIZE, 1, fp);
+
+    unsigned long offset = LEVELPACK_HEADER_SIZE + count * LEVELPACK_ENTRY_SIZE;
+    for(int pass = 0; pass < 2; pass++){
+        for(int i = 0; i < count; i++){
+            unsigned long size;
+            unsigned char *data = readFile(levels[i], &size);
+            if(!data){
+                printf("error reading %s\n", levels[i]);
+                fclose(fp);
+                return 0;
+            }
+
+            if(!pass){
+                const char *name = strrchr(levels[i], '/');
+                name = name ? name + 1 : levels[i];
+                if(strlen(name) >= LEVELPACK_NAME_LEN){
+                    printf("level name %s is too long\n", name);
+                    free(data);
+                    fclose(fp);
+                    return 0;
+                }
+
+                unsigned char entry[LEVELPACK_ENTRY_SIZE] = {0};
+                strcpy((char *)entry, name);
+                put32(&entry[LEVELPACK_NAME_LEN], offset);
+                put32(&entry[LEVELPACK_NAME_LEN + 4], size);
+                put32(&entry[LEVELPACK_NAME_LEN + 8], LevelPack_Checksum(data, size));
+                fwrite(entry, LEVELPACK_ENTRY_SIZE, 1, fp);
+                offset += size;
+            }
+            else
+                fwrite(data, 1, size, fp);
+            free(data);
+        }
+    }
+    fclose(fp);
+    return 1;
+}
+
+//open the pack the way the game does and read every level back
+static int readBack(const char *file, int count){
+    LevelPack_t pack;
+    if(!LevelPack_Open(&pack, file) || pack.count != count)
+        return 0;
+
+    int ok = 1;
+    for(int i = 0; i < pack.count && ok; i++){
+        unsigned long length;
+        int owned;
+        const unsigned char *data = LevelPack_Read(&pack, i, &length, &owned);
+        ok = data != NULL;
+        if(ok)
+            printf("%s: %s, %lu bytes\n", file, pack.index[i].name, length);
+        if(owned)
+            free((void *)data);
+    }
+    LevelPack_Close(&pack);
+    return ok;
+}
+
+int main(int argc, char *argv[]){
+    if(argc < 3){
+        printf("usage: %s out.pak level...\n", argv[0]);
+        return 1;
+    }
+    if(argc - 2 > LEVELPACK_MAX_LEVELS){
+        printf("at most %d levels fit in a pack\n", LEVELPACK_MAX_LEVELS);
+        return 1;
+    }
+
+    if(!writePack(argv[1], &argv[2], argc - 2) || !readBack(argv[1], argc - 2)){
+        printf("error writing %s\n", argv[1]);
+        remove(argv[1]);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,103 @@
+/*
+*Sprite converter, decodes a png once on the host and writes it as a .spr
+*(see src/sprite.h) so the game can copy the pixels in without decoding.
+*The png is decoded by the host libBAG, the same way the game would load it,
+*and the result is read back with src/sprite.c to check it.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "sprite.h"
+
+static void put16(unsigned char *dest, int value){
+    dest[0] = value;
+    dest[1] = value >> 8;
+}
+
+static int writeSpr(GFXObj_t *obj, const char *file){
+    FILE *fp = fopen(file, "wb");
+    if(!fp)
+        return 0;
+
+    unsigned char header[SPRITE_HEADER_SIZE] = {0};
+    memcpy(header, SPRITE_MAGIC, 4);
+    put16(&header[4], SPRITE_VERSION);
+    put16(&header[6], obj->width);
+    put16(&header[8], obj->height);
+    put16(&header[10], obj->frameWd);
+    put16(&header[12], obj->frameHt);
+    int ok = fwrite(header, SPRITE_HEADER_SIZE, 1, fp) == 1;
+
+    //pixels are stored little endian whatever the host is
+    int count = obj->width * obj->height;
+    unsigned char *pixels = malloc(count * 2);
+    if(!pixels){
+        fclose(fp);
+        return 0;
+    }
+    for(int i = 0; i < count; i++)
+        put16(&pixels[i * 2], obj->buffer[i]);
+    ok = ok && fwrite(pixels, 2, count, fp) == (size_t)count;
+    free(pixels);
+    return fclose(fp) == 0 && ok;
+}
+
+static int readBack(GFXObj_t *obj, const char *file){
+    GFXObj_t check = {0};
+    if(Sprite_LoadRaw(file, &check) != NO_ERR)
+        return 0;
+
+    int ok = check.width == obj->width && check.height == obj->height &&
+             check.frameWd == obj->frameWd && check.frameHt == obj->frameHt &&
+             !memcmp(check.buffer, obj->buffer, obj->width * obj->height * sizeof(unsigned short));
+    BAG_Display_DeleteObj(&check);
+    return ok;
+}
+
+static void usage(const char *name){
+    printf("usage: %s [-f WxH] in.png out.spr\n", name);
+    printf("  -f  frame size, the whole image by default\n");
+}
+
+int main(int argc, char *argv[]){
+    int opt, frameWd = 0, frameHt = 0;
+    while((opt = getopt(argc, argv, "f:h")) != -1){
+        switch(opt){
+            case 'f':
+                if(sscanf(optarg, "%dx%d", &frameWd, &frameHt) != 2 || frameWd <= 0 || frameHt <= 0){
+                    printf("bad frame size %s\n", optarg);
+                    return 1;
+                }
+            break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if(argc - optind != 2){
+        usage(argv[0]);
+        return 1;
+    }
+    const char *in = argv[optind], *out = argv[optind + 1];
+
+    GFXObj_t obj = {0};
+    if(BAG_Display_LoadObjExt(in, &obj) != NO_ERR){
+        printf("error reading %s\n", in);
+        return 1;
+    }
+    if(frameWd)
+        BAG_Display_SetGfxFrameDim(&obj, frameWd, frameHt);
+    if(obj.width > 0xffff || obj.height > 0xffff || obj.width % obj.frameWd || obj.height % obj.frameHt){
+        printf("%s does not split into %dx%d frames\n", in, obj.frameWd, obj.frameHt);
+        return 1;
+    }
+
+    if(!writeSpr(&obj, out) || !readBack(&obj, out)){
+        printf("error writing %s\n", out);
+        remove(out);
+        return 1;
+    }
+    BAG_Display_DeleteObj(&obj);
+    return 0;
+}
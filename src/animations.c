@@ -1,9 +1,34 @@
 #include "animations.h"
 
+static void setFrame(AnimData *profile, int frame){
+    profile->cur->frame = frame;
+    BAG_Display_SetObjFrame(profile->gfx, FRAME_HOR, frame);
+}
+
+//the library steps the gfx, the game's count follows firstFrame..lastFrame by speed/frames of a frame per run
+static void stepFrame(AnimData *profile){
+    BAG_Display_UpdateAnim(profile->gfx, profile->firstFrame, profile->lastFrame, profile->speed, profile->frames, FRAME_HOR);
+
+    AnimFrame_t *cur = profile->cur;
+    if(!cur->running || profile->frames <= 0)
+        return;
+
+    int frame = cur->frame;
+    if(frame < profile->firstFrame || frame > profile->lastFrame)
+        frame = profile->firstFrame;
+    cur->timer += profile->speed;
+    while(cur->timer >= profile->frames){
+        cur->timer -= profile->frames;
+        if(++frame > profile->lastFrame)
+            frame = profile->firstFrame;
+    }
+    cur->frame = frame;
+}
+
 void Animation_RunProfile(AnimData *profile){
     //set to idle frame if loop is over and wait one cycle
     if(profile->loop > -1 && !profile->done && profile->loopTimes >= profile->loop){
-        BAG_Display_SetObjFrame(profile->gfx, FRAME_HOR, profile->idleFrame);
+        setFrame(profile, profile->idleFrame);
 
         if(profile->loopTimes >= profile->loop + 1){
             profile->done = 1;
@@ -24,7 +49,7 @@ void Animation_RunProfile(AnimData *profile){
     #ifdef FRAME_USE_VARIABLE_SIZE
         BAG_Display_SetGfxFrameDim(profile->gfx, profile->frameWd, profile->frameHt);
     #endif
-    BAG_Display_UpdateAnim(profile->gfx, profile->firstFrame, profile->lastFrame, profile->speed, profile->frames, FRAME_HOR);
+    stepFrame(profile);
     profile->loopIncrement++;
     if(profile->loopIncrement > abs(profile->firstFrame - profile->lastFrame)){
         profile->loopIncrement = 0;
@@ -37,5 +62,6 @@ void Animation_ResetProfile(AnimData *profile){
     profile->done = 0;
     profile->loopTimes = 0;
     profile->loopIncrement = 0;
+    profile->cur->running = 1;
     BAG_Display_StartAnim(profile->gfx);//enable animation for graphics set
 }
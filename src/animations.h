@@ -10,6 +10,15 @@ extern "C" {
 #define FRAME_USE_VARIABLE_SIZE
 #define FRAME_USE_PIXEL_OFFSET
 
+//libBAG steps the frame a gfx shows but has no way to read it back, so the game
+//keeps its own count alongside for snapshots, the state hash and span drawing.
+//It takes the same arguments as the library call and is set on the gfx whenever
+//it is put back. Profiles drawing the same gfx share one.
+typedef struct AnimFrame_t{
+    int frame, timer;
+    char running;
+}AnimFrame_t;
+
 typedef struct AnimData{
     GFXObj_t *gfx;
     char firstFrame, lastFrame, idleFrame;
@@ -20,7 +29,7 @@ typedef struct AnimData{
     #ifdef FRAME_USE_VARIABLE_SIZE
         int frameWd, frameHt;
     #endif
-
+    AnimFrame_t *cur;
 }AnimData;
 
 extern void Animation_RunProfile(AnimData *profile);
@@ -0,0 +1,172 @@
+#include "ballPool.h"
+
+void BallPool_Init(BallPool_t *pool, GFXObj_t *gfx, const SpanMask_t *mask){
+    memset(pool, 0, sizeof(BallPool_t));
+    pool->gfx = gfx;
+    pool->mask = mask;
+    pool->wd = *BAG_Display_GetGfxFrameWd(gfx);
+    pool->ht = *BAG_Display_GetGfxFrameHt(gfx);
+}
+
+static void setVelocity(BallPool_t *pool, int i, int speed, int angle){
+    pool->speed[i] = speed;
+    pool->angle[i] = angle & 511;
+    pool->vx[i] = BAG_Cos(angle) * fix_norm(speed);
+    pool->vy[i] = BAG_Sin(angle) * fix_norm(speed);
+}
+
+//x and y are fixed point, returns the slot used or -1 when the pool is full
+int BallPool_Spawn(BallPool_t *pool, int x, int y, int speed, int angle){
+    int i = 0;
+    while(i < pool->count && pool->alive[i])
+        i++;
+    if(i >= BALL_POOL_MAX)
+        return -1;
+    if(i == pool->count)
+        pool->count++;
+
+    pool->alive[i] = 1;
+    pool->x[i] = pool->lastX[i] = x;
+    pool->y[i] = pool->lastY[i] = y;
+    setVelocity(pool, i, speed, angle);
+    return i;
+}
+
+//slots at the end with no ball are free again
+static void trimCount(BallPool_t *pool){
+    while(pool->count > 0 && !pool->alive[pool->count - 1])
+        pool->count--;
+}
+
+//every live ball spawns two more spread to either side of it
+void BallPool_Split(BallPool_t *pool, int spread){
+    int count = pool->count;
+    for(int i = 0; i < count; i++){
+        if(!pool->alive[i])
+            continue;
+        BallPool_Spawn(pool, pool->x[i], pool->y[i], pool->speed[i], pool->angle[i] + spread);
+        BallPool_Spawn(pool, pool->x[i], pool->y[i], pool->speed[i], pool->angle[i] - spread);
+    }
+}
+
+//remove any live ball from the pool, returning its state
+int BallPool_Take(BallPool_t *pool, int *x, int *y, int *speed, int *angle){
+    for(int i = 0; i < pool->count; i++){
+        if(!pool->alive[i])
+            continue;
+        pool->alive[i] = 0;
+        *x = pool->x[i];
+        *y = pool->y[i];
+        *speed = pool->speed[i];
+        *angle = pool->angle[i];
+        trimCount(pool);
+        return 1;
+    }
+    return 0;
+}
+
+int BallPool_Live(BallPool_t *pool){
+    int live = 0;
+    for(int i = 0; i < pool->count; i++)
+        live += pool->alive[i];
+    return live;
+}
+
+//bounce balls heading down off the paddle, same overlap test as obj_collision_PtObj,
+//steered by how far from the paddles centre they hit
+void BallPool_PaddleCollision(BallPool_t *pool, Point_t *paddlePos, GFXObj_t *paddle, int minSteer, int maxSteer){
+    int w2 = *BAG_Display_GetGfxFrameWd(paddle),
+        h2 = *BAG_Display_GetGfxFrameHt(paddle),
+        x2 = fix_norm(*point_getX(paddlePos)) + (w2 >> 1),
+        y2 = fix_norm(*point_getY(paddlePos)) + (h2 >> 1),
+        rangeX = (pool->wd + w2) >> 1,
+        rangeY = (pool->ht + h2) >> 1;
+
+    for(int i = 0; i < pool->count; i++){
+        int x1 = fix_norm(pool->x[i]) + (pool->wd >> 1),
+            y1 = fix_norm(pool->y[i]) + (pool->ht >> 1);
+        if(pool->alive[i] && pool->vy[i] > 0 && abs(x2 - x1) <= rangeX && abs(y2 - y1) <= rangeY)
+            setVelocity(pool, i, pool->speed[i], angle_steer(x1 - x2, w2 >> 1, pool->vx[i], minSteer, maxSteer));
+    }
+}
+
+//move every ball and bounce it off the walls
+void BallPool_Update(BallPool_t *pool){
+    int maxX = norm_fix(GAME_WIDTH - pool->wd);
+
+    for(int i = 0; i < pool->count; i++){
+        if(!pool->alive[i])
+            continue;
+
+        pool->lastX[i] = pool->x[i];
+        pool->lastY[i] = pool->y[i];
+        pool->x[i] += pool->vx[i];
+        pool->y[i] += pool->vy[i];
+
+        if(pool->y[i] < 0 && pool->vy[i] < 0){
+            pool->vy[i] = -pool->vy[i];
+            pool->angle[i] = FLIP_VERT(pool->angle[i]);
+        }
+        if((pool->x[i] < 0 && pool->vx[i] < 0) || (pool->x[i] > maxX && pool->vx[i] > 0)){
+            pool->vx[i] = -pool->vx[i];
+            pool->angle[i] = FLIP_HOR(pool->angle[i]);
+        }
+        if(fix_norm(pool->y[i]) >= GAME_HEIGHT)
+            pool->alive[i] = 0;
+    }
+    trimCount(pool);
+}
+
+void BallPool_BrickCollision(BallPool_t *pool, Point_t *bgPos, TileGrid_t *bg, const unsigned int *rows, char (*processTile)(unsigned char *)){
+    TileHit_t hit;
+    for(int i = 0; i < pool->count; i++){
+        if(!pool->alive[i])
+            continue;
+        if(rows && !obj_sweepRowsOccupied(pool->lastY[i], pool->ht, pool->y[i] - pool->lastY[i], bgPos, bg, rows))
+            continue;
+
+        int flags = obj_sweepTile(pool->lastX[i], pool->lastY[i], pool->wd, pool->ht,
+                                  pool->x[i] - pool->lastX[i], pool->y[i] - pool->lastY[i], bgPos, bg, &hit);
+        if(!flags || !processTile(hit.tile))
+            continue;
+
+        pool->x[i] = hit.x;
+        pool->y[i] = hit.y;
+        if(GET_FLAG(flags, COLLISION_UP | COLLISION_DOWN)){
+            pool->vy[i] = -pool->vy[i];
+            pool->angle[i] = FLIP_VERT(pool->angle[i]);
+        }
+        if(GET_FLAG(flags, COLLISION_LEFT | COLLISION_RIGHT)){
+            pool->vx[i] = -pool->vx[i];
+            pool->angle[i] = FLIP_HOR(pool->angle[i]);
+        }
+    }
+}
+
+void BallPool_MarkDirty(DirtyMap_t *dirty, BallPool_t *pool){
+    //slots freed since the last pass may still have a ball on screen to erase
+    int slots = (pool->drawnCount > pool->count) ? pool->drawnCount : pool->count;
+    pool->drawnCount = 0;
+    for(int i = 0; i < slots; i++){
+        if(pool->drawn[i])
+            Dirty_MarkRect(dirty, pool->drawnX[i], pool->drawnY[i], pool->wd, pool->ht);
+
+        pool->drawn[i] = i < pool->count && pool->alive[i];
+        if(pool->drawn[i]){
+            pool->drawnX[i] = fix_norm(pool->x[i]);
+            pool->drawnY[i] = fix_norm(pool->y[i]);
+            Dirty_MarkRect(dirty, pool->drawnX[i], pool->drawnY[i], pool->wd, pool->ht);
+            pool->drawnCount = i + 1;
+        }
+    }
+}
+
+void BallPool_Draw(const Surface_t *dest, BallPool_t *pool){
+    //every ball shows the one frame, so look its spans up once
+    int frame = 0;
+    const SpanStrip_t *strip = SpanMask_Find(pool->mask, pool->gfx, frame);
+    for(int i = 0; i < pool->count; i++){
+        if(pool->alive[i])
+            SpanMask_DrawFound(pool->mask, strip, frame, pool->gfx, pool->drawnX[i], pool->drawnY[i], dest);
+    }
+}
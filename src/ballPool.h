@@ -0,0 +1,58 @@
+#ifndef _BALLPOOL_H_
+#define _BALLPOOL_H_
+
+#include <libBAG.h>
+#include "quick2dEngine.h"
+#include "dirtyRect.h"
+#include "spanMask.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BALL_POOL_MAX 256
+
+/*
+Extra balls (multiball) kept as parallel arrays so every update step is a
+straight loop over plain ints. Velocity is stored directly in fixed point and
+only recomputed from the angle when a ball is spawned.
+*/
+typedef struct BallPool_t{
+    GFXObj_t *gfx;
+    const SpanMask_t *mask;//opaque runs of gfx, drawn color keyed without one
+    int wd, ht;
+    int count;//one past the highest slot in use
+
+    int x[BALL_POOL_MAX], y[BALL_POOL_MAX],
+        vx[BALL_POOL_MAX], vy[BALL_POOL_MAX],
+        lastX[BALL_POOL_MAX], lastY[BALL_POOL_MAX],
+        speed[BALL_POOL_MAX];
+    short angle[BALL_POOL_MAX];
+    char alive[BALL_POOL_MAX];
+
+    //where each ball was last drawn, in pixels
+    short drawnX[BALL_POOL_MAX], drawnY[BALL_POOL_MAX];
+    char drawn[BALL_POOL_MAX];
+    int drawnCount;//one past the highest slot drawn, may be past count until it is erased
+}BallPool_t;
+
+extern void BallPool_Init(BallPool_t *pool, GFXObj_t *gfx, const SpanMask_t *mask);
+extern int BallPool_Spawn(BallPool_t *pool, int x, int y, int speed, int angle);
+extern void BallPool_Split(BallPool_t *pool, int spread);
+extern int BallPool_Take(BallPool_t *pool, int *x, int *y, int *speed, int *angle);
+extern int BallPool_Live(BallPool_t *pool);
+
+extern void BallPool_PaddleCollision(BallPool_t *pool, Point_t *paddlePos, GFXObj_t *paddle, int minSteer, int maxSteer);
+extern void BallPool_Update(BallPool_t *pool);
+//rows is an optional mask per map row of where bricks are left, balls only in empty rows skip the sweep
+extern void BallPool_BrickCollision(BallPool_t *pool, Point_t *bgPos, TileGrid_t *bg, const unsigned int *rows, char (*processTile)(unsigned char *));
+
+extern void BallPool_MarkDirty(DirtyMap_t *dirty, BallPool_t *pool);
+extern void BallPool_Draw(const Surface_t *dest, BallPool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif
@@ -0,0 +1,156 @@
+#include "blit.h"
+
+#if defined(BAG_HOST_BUILD) && (defined(__x86_64__) || defined(__i386__))
+    #define BLIT_X86
+    #include <immintrin.h>
+#endif
+
+static void copyC(unsigned short *dest, const unsigned short *src, int count){
+    memcpy(dest, src, count << 1);
+}
+
+static void copyKeyedC(unsigned short *dest, const unsigned short *src, int count){
+    for(int i = 0; i < count; i++){
+        if(src[i] != TRANS_COLOR)
+            dest[i] = src[i];
+    }
+}
+
+static void fillC(unsigned short *dest, unsigned short color, int count){
+    for(int i = 0; i < count; i++)
+        dest[i] = color;
+}
+
+#ifdef BLIT_X86
+/*
+Rows shorter than a vector are done in C. Otherwise the last vector is lined up
+with the end of the row, overlapping the one before it instead of finishing
+pixel by pixel. Redoing a pixel gives the same result for all three kernels.
+*/
+__attribute__((target("sse2")))
+static inline void copy8(unsigned short *dest, const unsigned short *src){
+    _mm_storeu_si128((__m128i *)dest, _mm_loadu_si128((const __m128i *)src));
+}
+
+__attribute__((target("sse2")))
+static inline void copyKeyed8(unsigned short *dest, const unsigned short *src, __m128i key){
+    __m128i s = _mm_loadu_si128((const __m128i *)src),
+            see = _mm_cmpeq_epi16(s, key);
+    //keep dest where src is see through
+    _mm_storeu_si128((__m128i *)dest, _mm_or_si128(_mm_and_si128(see, _mm_loadu_si128((const __m128i *)dest)),
+                                                    _mm_andnot_si128(see, s)));
+}
+
+__attribute__((target("sse2")))
+static void copySSE2(unsigned short *dest, const unsigned short *src, int count){
+    if(count < 8){
+        copyC(dest, src, count);
+        return;
+    }
+    for(int i = 0; i < count - 8; i += 8)
+        copy8(&dest[i], &src[i]);
+    copy8(&dest[count - 8], &src[count - 8]);
+}
+
+__attribute__((target("sse2")))
+static void copyKeyedSSE2(unsigned short *dest, const unsigned short *src, int count){
+    if(count < 8){
+        copyKeyedC(dest, src, count);
+        return;
+    }
+    const __m128i key = _mm_set1_epi16((short)TRANS_COLOR);
+    for(int i = 0; i < count - 8; i += 8)
+        copyKeyed8(&dest[i], &src[i], key);
+    copyKeyed8(&dest[count - 8], &src[count - 8], key);
+}
+
+__attribute__((target("sse2")))
+static void fillSSE2(unsigned short *dest, unsigned short color, int count){
+    if(count < 8){
+        fillC(dest, color, count);
+        return;
+    }
+    const __m128i c = _mm_set1_epi16((short)color);
+    for(int i = 0; i < count - 8; i += 8)
+        _mm_storeu_si128((__m128i *)&dest[i], c);
+    _mm_storeu_si128((__m128i *)&dest[count - 8], c);
+}
+
+__attribute__((target("avx2")))
+static void copyAVX2(unsigned short *dest, const unsigned short *src, int count){
+    if(count < 16){
+        copySSE2(dest, src, count);
+        return;
+    }
+    for(int i = 0; i < count - 16; i += 16)
+        _mm256_storeu_si256((__m256i *)&dest[i], _mm256_loadu_si256((const __m256i *)&src[i]));
+    _mm256_storeu_si256((__m256i *)&dest[count - 16], _mm256_loadu_si256((const __m256i *)&src[count - 16]));
+}
+
+__attribute__((target("avx2")))
+static inline void copyKeyed16(unsigned short *dest, const unsigned short *src, __m256i key){
+    __m256i s = _mm256_loadu_si256((const __m256i *)src);
+    _mm256_storeu_si256((__m256i *)dest, _mm256_blendv_epi8(s, _mm256_loadu_si256((const __m256i *)dest),
+                                                            _mm256_cmpeq_epi16(s, key)));
+}
+
+__attribute__((target("avx2")))
+static void copyKeyedAVX2(unsigned short *dest, const unsigned short *src, int count){
+    if(count < 16){
+        copyKeyedSSE2(dest, src, count);
+        return;
+    }
+    const __m256i key = _mm256_set1_epi16((short)TRANS_COLOR);
+    for(int i = 0; i < count - 16; i += 16)
+        copyKeyed16(&dest[i], &src[i], key);
+    copyKeyed16(&dest[count - 16], &src[count - 16], key);
+}
+
+__attribute__((target("avx2")))
+static void fillAVX2(unsigned short *dest, unsigned short color, int count){
+    if(count < 16){
+        fillSSE2(dest, color, count);
+        return;
+    }
+    const __m256i c = _mm256_set1_epi16((short)color);
+    for(int i = 0; i < count - 16; i += 16)
+        _mm256_storeu_si256((__m256i *)&dest[i], c);
+    _mm256_storeu_si256((__m256i *)&dest[count - 16], c);
+}
+#endif
+
+//fastest first
+static const BlitKernels_t Kernels[] = {
+    #ifdef BLIT_X86
+        {"avx2", &copyAVX2, &copyKeyedAVX2, &fillAVX2},
+        {"sse2", &copySSE2, &copyKeyedSSE2, &fillSSE2},
+    #endif
+    {"c", &copyC, &copyKeyedC, &fillC},
+};
+
+BlitKernels_t Blit = {"c", &copyC, &copyKeyedC, &fillC};
+
+static int supported(const BlitKernels_t *kernels){
+    #ifdef BLIT_X86
+        if(!strcmp(kernels->name, "avx2"))
+            return __builtin_cpu_supports("avx2");
+        if(!strcmp(kernels->name, "sse2"))
+            return __builtin_cpu_supports("sse2");
+    #endif
+    return 1;
+}
+
+int Blit_Init(const char *name){
+    for(unsigned int i = 0; i < sizeof(Kernels) / sizeof(BlitKernels_t); i++){
+        if(name && strcmp(Kernels[i].name, name))
+            continue;
+        if(!supported(&Kernels[i])){
+            if(name)
+                return 0;
+            continue;
+        }
+        memcpy(&Blit, &Kernels[i], sizeof(BlitKernels_t));
+        return 1;
+    }
+    return 0;
+}
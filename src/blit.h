@@ -0,0 +1,35 @@
+#ifndef _BLIT_H_
+#define _BLIT_H_
+
+#include <libBAG.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+16bpp pixel moves used by the dirty cell copies and brick compositing. Plain C
+by default, the host build picks SSE2 or AVX2 versions at run time where the
+cpu has them. Counts are in pixels.
+*/
+//magenta, the see through key of the sprites and what the png loader writes for clear pixels
+#define TRANS_COLOR 0x7C1F
+
+typedef struct BlitKernels_t{
+    const char *name;
+    void (*copy)(unsigned short *dest, const unsigned short *src, int count);
+    //skips src pixels that are TRANS_COLOR
+    void (*copyKeyed)(unsigned short *dest, const unsigned short *src, int count);
+    void (*fill)(unsigned short *dest, unsigned short color, int count);
+}BlitKernels_t;
+
+extern BlitKernels_t Blit;
+
+//switch to the named kernels ("c", "sse2", "avx2"), NULL takes the fastest the cpu runs
+extern int Blit_Init(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,137 @@
+#include "dirtyRect.h"
+#include "sprite.h"
+
+void Dirty_Clear(DirtyMap_t *map){
+    memset(map, 0, sizeof(DirtyMap_t));
+}
+
+void Dirty_MarkAll(DirtyMap_t *map){
+    for(int i = 0; i < DIRTY_ROWS; i++)
+        map->rows[i] = (1u << DIRTY_COLS) - 1;
+}
+
+void Dirty_MarkRect(DirtyMap_t *map, int x, int y, int wd, int ht){
+    if(wd <= 0 || ht <= 0)
+        return;
+
+    //clip to the game area
+    int x2 = x + wd - 1, y2 = y + ht - 1;
+    if(x < 0) x = 0;
+    if(y < 0) y = 0;
+    if(x2 >= GAME_WIDTH) x2 = GAME_WIDTH - 1;
+    if(y2 >= GAME_HEIGHT) y2 = GAME_HEIGHT - 1;
+    if(x > x2 || y > y2)
+        return;
+
+    int col1 = x >> DIRTY_CELL_DIVX, col2 = x2 >> DIRTY_CELL_DIVX;
+    unsigned int bits = ((2u << col2) - 1) & ~((1u << col1) - 1);
+    for(int row = y >> DIRTY_CELL_DIVY; row <= (y2 >> DIRTY_CELL_DIVY); row++)
+        map->rows[row] |= bits;
+}
+
+//mark where an object was last drawn and where it is now
+void Dirty_MarkMoved(DirtyMap_t *map, DirtyRect_t *last, int x, int y, int wd, int ht){
+    Dirty_MarkRect(map, last->x, last->y, last->wd, last->ht);
+    Dirty_MarkRect(map, x, y, wd, ht);
+    last->x = x;
+    last->y = y;
+    last->wd = wd;
+    last->ht = ht;
+}
+
+int Dirty_IsEmpty(const DirtyMap_t *map){
+    unsigned int any = 0;
+    for(int i = 0; i < DIRTY_ROWS; i++)
+        any |= map->rows[i];
+    return !any;
+}
+
+void Dirty_Union(DirtyMap_t *dest, const DirtyMap_t *a, const DirtyMap_t *b){
+    for(int i = 0; i < DIRTY_ROWS; i++)
+        dest->rows[i] = a->rows[i] | b->rows[i];
+}
+
+//copy dirty cells in rows firstRow to lastRow - 1, dest starts at the top of firstRow
+void Dirty_Copy(const DirtyMap_t *map, int firstRow, int lastRow, unsigned short *dest, int destWd,
+                const unsigned short *src, int srcWd, int srcHt){
+    if(src == NULL || dest == NULL)
+        return;
+
+    for(int row = firstRow; row < lastRow; row++){
+        unsigned int mask = map->rows[row];
+        int col = 0;
+        while(mask){
+            //skip to the next run of dirty cells and copy it in one go
+            while(!(mask & 1)){
+                mask >>= 1;
+                col++;
+            }
+            int len = 0;
+            while(mask & 1){
+                mask >>= 1;
+                len++;
+            }
+
+            int x = col << DIRTY_CELL_DIVX, wd = len << DIRTY_CELL_DIVX;
+            col += len;
+            if(x + wd > srcWd)
+                wd = srcWd - x;
+            if(wd <= 0)
+                continue;
+
+            int y = row << DIRTY_CELL_DIVY;
+            unsigned short *d = &dest[((row - firstRow) << DIRTY_CELL_DIVY) * destWd + x];
+            for(int i = 0; i < DIRTY_CELL_HT && y + i < srcHt; i++, d += destWd)
+                Blit.copy(d, &src[(y + i) * srcWd + x], wd);
+        }
+    }
+}
+
+//fill every dirty cell of a game sized buffer
+void Dirty_Fill(const DirtyMap_t *map, unsigned short *dest, int destWd, unsigned short color){
+    for(int row = 0; row < DIRTY_ROWS; row++){
+        unsigned int mask = map->rows[row];
+        for(int col = 0; mask; col++, mask >>= 1){
+            if(!(mask & 1))
+                continue;
+            unsigned short *d = &dest[(row << DIRTY_CELL_DIVY) * destWd + (col << DIRTY_CELL_DIVX)];
+            for(int i = 0; i < DIRTY_CELL_HT; i++, d += destWd)
+                Blit.fill(d, color, DIRTY_CELL_WD);
+        }
+    }
+}
+
+//color keyed draw of a horizontal frame, only touching pixels inside the clip rect
+void Dirty_DrawFrameClipped(GFXObj_t *gfx, int frame, unsigned short *dest, int destWd, int x, int y,
+                            int clipX, int clipY, int clipWd, int clipHt){
+    unsigned short *buf = BAG_Display_GetGfxBuf(gfx);
+    if(buf == NULL)
+        return;
+
+    int sheetWd = Sprite_Width(gfx),
+        wd = *BAG_Display_GetGfxFrameWd(gfx),
+        ht = *BAG_Display_GetGfxFrameHt(gfx),
+        srcX = frame * wd, srcY = 0;
+
+    if(x < clipX){
+        wd -= clipX - x;
+        srcX += clipX - x;
+        x = clipX;
+    }
+    if(y < clipY){
+        ht -= clipY - y;
+        srcY += clipY - y;
+        y = clipY;
+    }
+    if(x + wd > clipX + clipWd)
+        wd = clipX + clipWd - x;
+    if(y + ht > clipY + clipHt)
+        ht = clipY + clipHt - y;
+    if(srcX + wd > sheetWd)
+        wd = sheetWd - srcX;
+
+    if(wd <= 0)
+        return;
+    for(int i = 0; i < ht; i++)
+        Blit.copyKeyed(&dest[(y + i) * destWd + x], &buf[(srcY + i) * sheetWd + srcX], wd);
+}
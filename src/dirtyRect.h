@@ -0,0 +1,61 @@
+#ifndef _DIRTYRECT_H_
+#define _DIRTYRECT_H_
+
+#include <libBAG.h>
+#include "quick2dEngine.h"
+#include "blit.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+The game area is split into 16x8 cells (the size of a brick), each frame only
+cells that something moved through or changed in are redrawn and flipped.
+*/
+#define DIRTY_CELL_WD 16
+#define DIRTY_CELL_HT 8
+#define DIRTY_CELL_DIVX 4
+#define DIRTY_CELL_DIVY 3
+
+#define DIRTY_COLS (GAME_WIDTH >> DIRTY_CELL_DIVX)
+#define DIRTY_ROWS (GAME_HEIGHT >> DIRTY_CELL_DIVY)
+
+/*
+Where the game area is drawn, one GAME_WIDTH wide buffer or the back buffers of
+both screens with the seam between them at SCREEN_HEIGHT.
+*/
+typedef struct Surface_t{
+    unsigned short *half[2];
+    int seam;//first row of half[1], GAME_HEIGHT when it is all in half[0]
+}Surface_t;
+
+typedef struct DirtyRect_t{
+    int x, y, wd, ht;
+}DirtyRect_t;
+
+typedef struct DirtyMap_t{
+    //one bit per cell column
+    unsigned int rows[DIRTY_ROWS];
+}DirtyMap_t;
+
+extern void Dirty_Clear(DirtyMap_t *map);
+extern void Dirty_MarkAll(DirtyMap_t *map);
+extern void Dirty_MarkRect(DirtyMap_t *map, int x, int y, int wd, int ht);
+extern void Dirty_MarkMoved(DirtyMap_t *map, DirtyRect_t *last, int x, int y, int wd, int ht);
+extern int Dirty_IsEmpty(const DirtyMap_t *map);
+extern void Dirty_Union(DirtyMap_t *dest, const DirtyMap_t *a, const DirtyMap_t *b);
+
+extern void Dirty_Copy(const DirtyMap_t *map, int firstRow, int lastRow, unsigned short *dest, int destWd,
+                       const unsigned short *src, int srcWd, int srcHt);
+extern void Dirty_Fill(const DirtyMap_t *map, unsigned short *dest, int destWd, unsigned short color);
+//gfx is a sheet from sprite.h or a view of one
+extern void Dirty_DrawFrameClipped(GFXObj_t *gfx, int frame, unsigned short *dest, int destWd, int x, int y,
+                                   int clipX, int clipY, int clipWd, int clipHt);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif
@@ -3,12 +3,29 @@
 #include "animations.h"
 #include "quick2dEngine.h"
 #include "filesys.h"
+#include "profile.h"
+#include "dirtyRect.h"
+#include "ballPool.h"
+#include "levelMap.h"
+#include "levelPack.h"
+#include "skinCache.h"
+#include "sprite.h"
+#include "spanMask.h"
+#include "simClock.h"
+#include "game.h"
+#include "replay.h"
+#include "snapshot.h"
+
+//draw the game straight into the screens' back buffers, without this it is
+//composed in Canvas and the changed cells are copied over when flipping
+#define DRAW_TO_SCREENS
 
 
 //important file paths
 const char RootDir[] = "/arkanoid/";
 const char SkinDir[] = "skins/";
 const char LevelDir[] = "levels/";
+const char LevelPackFile[] = "levels.pak";
 
 /*//===============================================
 Template object
@@ -16,18 +33,21 @@ Template object
 typedef struct Object_t{
     GFXObj_t *gfx;
     Point_t Pos;
-
-    void (*reset)(struct Bullet_t *);
-    void (*update)(struct Bullet_t *, int);
-    void (*setXY)(struct Bullet_t *, int, int);
-    void (*draw)(unsigned short *, struct Bullet_t *);
 }Object_t;
 
+//methods live in one const table, not in every object
+typedef struct ObjectMethods_t{
+    void (*reset)(Object_t *);
+    void (*update)(Object_t *, int);
+    void (*setXY)(Object_t *, int, int);
+    void (*draw)(unsigned short *, Object_t *);
+}ObjectMethods_t;
+
 
 static void objectSetXY(Bullet_t *obj, int x, int y){
     Point_t *pos = &obj->Pos;
-    (*pos->getX(pos)) = norm_fix(x);
-    (*pos->getY(pos)) = norm_fix(y);
+    (*point_getX(pos)) = norm_fix(x);
+    (*point_getY(pos)) = norm_fix(y);
 }
 
 static void objectReset(Object_t *obj){
@@ -40,13 +60,13 @@ static void objectReset(Object_t *obj){
 
 static void objectUpdate(Object_t *obj, int update){
     //update object here (controls or collisions)
-    obj->Pos.update(&obj->Pos);
+    point_update(&obj->Pos);
 }
 
 static void objectDraw(unsigned short *dest, Object_t *obj){
     GFXObj_t *gfx = bullet->gfx;
     Point_t *pos = &bullet->Pos;
-    BAG_Display_SetGfxBlitXY(gfx, fix_norm(*pos->getX(pos)), fix_norm(*pos->getY(pos)));
+    BAG_Display_SetGfxBlitXY(gfx, fix_norm(*point_getX(pos)), fix_norm(*point_getY(pos)));
     BAG_Display_DrawObjSlowEx(gfx, dest, GAME_WIDTH, GAME_HEIGHT);
 }
 
@@ -55,13 +75,12 @@ static void objectInit(Object_t *obj, GFXObj_t *gfx){
     memset(obj, 0, sizeof(Object_t));
     obj->gfx = gfx;
     initPoint(&obj->Pos);
-    //assign functions
-    obj->setXY = (void*)&objectSetXY;
-    obj->reset = (void*)&objectReset;
-    obj->update = (void*)&objectUpdate;
-    obj->draw = (void*)&objectDraw;
     objectReset(obj);
 }
+
+const ObjectMethods_t Object_Methods = {
+    &objectReset, &objectUpdate, &objectSetXY, &objectDraw,
+};
 */
 
 
@@ -73,22 +92,40 @@ Game stuff
 //#define BULLET_SPEED 1024
 #define PLAYER_SPEED 1024
 #define BALL_BASE_SPEED 1024
+//angle between the balls a multiball splits into
+#define MULTIBALL_SPREAD 40
+//largest level the brick occupancy masks can track
+#define LEVEL_MAX_COLS 32
+#define LEVEL_MAX_ROWS 64
+//tile values the brick type table covers, power of 2
+#define BRICK_TYPES_MAX 64
+//bytes of the next level read in each frame
+#define LEVEL_FETCH_CHUNK 512
+//how far from straight up the paddle can send a ball, out of 512
+#define PADDLE_MIN_STEER 24
+#define PADDLE_MAX_STEER 96
 
 
 typedef struct Ball_t{
     GFXObj_t *gfx;
+    const SpanMask_t *mask;
     Point_t Pos;
-
+    int lastX, lastY;//position before the last update, for swept collisions
     char died;
-    char (*collisionObj)(struct Ball_t *, GFXObj_t *);
-    int (*collisionBG)(struct Ball_t *, Point_t *, TiledBG_t *, unsigned int ***);
-    void (*launch)(struct Ball_t *, int, int);
-    void (*reset)(struct Ball_t *);
-    void (*update)(struct Ball_t *, int);
-    void (*setXY)(struct Ball_t *, int, int);
-    void (*draw)(unsigned short *, struct Ball_t *);
+    DirtyRect_t drawn;//where the ball was last drawn, after the fields the history captures
 }Ball_t;
 
+//the methods balls used to carry, for code that still calls them through pointers
+typedef struct BallMethods_t{
+    char (*collisionObj)(Ball_t *, GFXObj_t *);
+    int (*collisionBG)(Ball_t *, Point_t *, TiledBG_t *, unsigned int *[4][3]);
+    void (*launch)(Ball_t *, int, int);
+    void (*reset)(Ball_t *);
+    void (*update)(Ball_t *, int);
+    void (*setXY)(Ball_t *, int, int);
+    void (*draw)(const Surface_t *, Ball_t *);
+}BallMethods_t;
+
 
 
 static char ballCollisionObj(Ball_t * ball, GFXObj_t *target){
@@ -101,8 +138,8 @@ static int ballCollisionBG(Ball_t *ball, Point_t *bgPos, TiledBG_t *bg, unsigned
 
 static void ballSetXY(Ball_t *ball, int x, int y){
     Point_t *pos = &ball->Pos;
-    (*pos->getX(pos)) = norm_fix(x);
-    (*pos->getY(pos)) = norm_fix(y);
+    ball->lastX = (*point_getX(pos)) = norm_fix(x);
+    ball->lastY = (*point_getY(pos)) = norm_fix(y);
 }
 
 static void ballLaunch(Ball_t *ball, int speed, int angle){
@@ -122,30 +159,32 @@ static void ballReset(Ball_t *ball){
 static void ballUpdate(Ball_t *ball, int update){
     Point_t *pos = &ball->Pos;
     //reset ball if it goes off bottom
-    if(fix_norm(*pos->getY(pos)) >= GAME_HEIGHT)
+    if(fix_norm(*point_getY(pos)) >= GAME_HEIGHT)
         ball->died = 1;
 
+    ball->lastX = *point_getX(pos);
+    ball->lastY = *point_getY(pos);
     if(ball->died)
         return;
 
     //top wall collision
-    if(fix_norm(*pos->getY(pos)) < 0)
-        *pos->getAngle(pos) = angle_vertFlip(*pos->getAngle(pos));
+    if(fix_norm(*point_getY(pos)) < 0)
+        point_flipVert(pos);
 
     //left and right wall collisions
-    if(fix_norm(*pos->getX(pos)) < 0 || fix_norm(*pos->getX(pos)) > GAME_WIDTH - (*BAG_Display_GetGfxFrameWd(ball->gfx))){
-        *pos->getAngle(pos) = angle_horFlip(*pos->getAngle(pos));
-        ball->Pos.update(&ball->Pos);
+    if(fix_norm(*point_getX(pos)) < 0 || fix_norm(*point_getX(pos)) > GAME_WIDTH - (*BAG_Display_GetGfxFrameWd(ball->gfx))){
+        point_flipHor(pos);
+        point_update(&ball->Pos);
     }
 
-    ball->Pos.update(&ball->Pos);
+    point_update(&ball->Pos);
 }
 
-static void ballDraw(unsigned short *dest, Ball_t *ball){
+static void ballDraw(const Surface_t *dest, Ball_t *ball){
     GFXObj_t *gfx = ball->gfx;
     Point_t *pos = &ball->Pos;
-    BAG_Display_SetGfxBlitXY(gfx, fix_norm(*pos->getX(pos)), fix_norm(*pos->getY(pos)));
-    BAG_Display_DrawObjSlowEx(gfx, dest, GAME_WIDTH, GAME_HEIGHT);
+    BAG_Display_SetGfxBlitXY(gfx, fix_norm(*point_getX(pos)), fix_norm(*point_getY(pos)));
+    SpanMask_Draw(ball->mask, gfx, 0, dest);
 }
 
 static void ballInit(Ball_t *ball, GFXObj_t *gfx){
@@ -153,16 +192,12 @@ static void ballInit(Ball_t *ball, GFXObj_t *gfx){
 
     ball->gfx = gfx;
     initPoint(&ball->Pos);
-
-    ball->collisionObj = (void*)&ballCollisionObj;
-    ball->collisionBG = (void*)&ballCollisionBG;
-    ball->launch = (void*)&ballLaunch;
-    ball->reset = (void*)&ballReset;
-    ball->update = (void*)&ballUpdate;
-    ball->draw = (void*)&ballDraw;
-    ball->setXY = (void*)&ballSetXY;
     ballReset(ball);
 }
+
+const BallMethods_t Ball_Methods = {
+    &ballCollisionObj, &ballCollisionBG, &ballLaunch, &ballReset, &ballUpdate, &ballSetXY, &ballDraw,
+};
 /*==========================================================================
 Ship Info
 ==========================================================================*/
@@ -176,20 +211,27 @@ typedef enum{
 
 typedef struct Player_t{
     GFXObj_t *gfx, *ball_gfx;
+    const SpanMask_t *mask;//paddle frames of every animation
     AnimData Animations[TOTAL_ANIM];
+    AnimFrame_t frame;//paddle frame all of them step
 
     Point_t Pos;
     Ball_t Ball;
+    DirtyRect_t drawn;//where the paddle was last drawn
 
     unsigned int score;
     char lives, hit, isBig;
-
-    void (*update)(struct Player_t *, void (*extra)(void));
-    void (*draw) (unsigned short *, struct Player_t *);
-    void (*reset)(struct Player_t *);
-    void (*resetPos)(struct Player_t *);
 }Player_t;
 
+typedef struct PlayerMethods_t{
+    void (*update)(Player_t *, void (*extra)(void));
+    void (*animate)(Player_t *);
+    void (*markDirty)(DirtyMap_t *, Player_t *);
+    void (*draw) (const Surface_t *, Player_t *);
+    void (*reset)(Player_t *);
+    void (*resetPos)(Player_t *);
+}PlayerMethods_t;
+
 static void playerResetAnim(Player_t *p){
     for(int i = 0; i < TOTAL_ANIM; i++)
         Animation_ResetProfile(&p->Animations[i]);
@@ -197,15 +239,15 @@ static void playerResetAnim(Player_t *p){
 
 static void playerResetPos(Player_t *p){
     Point_t *pos = &p->Pos;
-    (*pos->getX(pos)) = norm_fix( (SCREEN_WIDTH - (*BAG_Display_GetGfxFrameWd(p->gfx)))>>1 );
-    (*pos->getY(pos)) = norm_fix(GAME_HEIGHT - 12);
-    (*pos->getSpeed(pos)) = 0;
-    p->Ball.reset(&p->Ball);
+    (*point_getX(pos)) = norm_fix( (SCREEN_WIDTH - (*BAG_Display_GetGfxFrameWd(p->gfx)))>>1 );
+    (*point_getY(pos)) = norm_fix(GAME_HEIGHT - 12);
+    (*point_getSpeed(pos)) = 0;
+    ballReset(&p->Ball);
 
     //set ball position
-    int tempX = fix_norm(*pos->getX(pos)) + (((*BAG_Display_GetGfxFrameWd(p->gfx)) + (*BAG_Display_GetGfxFrameWd(p->Ball.gfx)))>>1);
-    int tempY = fix_norm(*pos->getY(pos)) - (*BAG_Display_GetGfxFrameHt(p->Ball.gfx));
-    p->Ball.setXY(&p->Ball, tempX, tempY);
+    int tempX = fix_norm(*point_getX(pos)) + (((*BAG_Display_GetGfxFrameWd(p->gfx)) + (*BAG_Display_GetGfxFrameWd(p->Ball.gfx)))>>1);
+    int tempY = fix_norm(*point_getY(pos)) - (*BAG_Display_GetGfxFrameHt(p->Ball.gfx));
+    ballSetXY(&p->Ball, tempX, tempY);
 }
 
 static void playerReset(Player_t *p){
@@ -217,9 +259,9 @@ static void playerReset(Player_t *p){
 
 static void playerUpdate(Player_t *p, void (*extra)(void)){
 
-    if(*p->Ball.Pos.getSpeed(&p->Ball.Pos) == 0 || p->Ball.died /*&& p->Animations[SPAWN_ANIM].done)*/){
+    if(*point_getSpeed(&p->Ball.Pos) == 0 || p->Ball.died /*&& p->Animations[SPAWN_ANIM].done)*/){
         if(Pad.Newpress.A){
-            p->Ball.launch(&p->Ball, BALL_BASE_SPEED, ANGLE_UP_RIGHT);
+            ballLaunch(&p->Ball, BALL_BASE_SPEED, ANGLE_UP_RIGHT);
             p->Ball.died = 0;
             p->lives--;
             playerResetAnim(p);
@@ -239,34 +281,36 @@ static void playerUpdate(Player_t *p, void (*extra)(void)){
     }
 
     Point_t *pos = &p->Pos;
-    (*pos->getSpeed(pos)) = 0;//no movement when no pads are held
+    (*point_getSpeed(pos)) = 0;//no movement when no pads are held
     if(Pad.Held.Left){
-        (*pos->getSpeed(pos)) = PLAYER_SPEED;
-        (*pos->getAngle(pos)) = ANGLE_LEFT;
+        (*point_getSpeed(pos)) = PLAYER_SPEED;
+        (*point_getAngle(pos)) = ANGLE_LEFT;
     }
     else if(Pad.Held.Right){
-        (*pos->getSpeed(pos)) = PLAYER_SPEED;
-        (*pos->getAngle(pos)) = ANGLE_RIGHT;
+        (*point_getSpeed(pos)) = PLAYER_SPEED;
+        (*point_getAngle(pos)) = ANGLE_RIGHT;
     }
 
-    //ball and paddle collision
-    if(p->Ball.collisionObj(&p->Ball, p->gfx))
-        *p->Ball.Pos.getAngle(&p->Ball.Pos) = angle_vertFlip(*p->Ball.Pos.getAngle(&p->Ball.Pos));
+    //ball and paddle collision, the further from the centre the ball lands the wider it bounces.
+    //the paddle has not moved yet this step, it is still where the last step left it
+    Point_t *ballPos = &p->Ball.Pos;
+    if(BAG_Sin(*point_getAngle(ballPos)) > 0 && obj_collision_PtPt(ballPos, p->Ball.gfx, pos, p->gfx)){
+        int half = (*BAG_Display_GetGfxFrameWd(p->gfx)) >> 1,
+            offset = fix_norm(*point_getX(ballPos)) + ((*BAG_Display_GetGfxFrameWd(p->Ball.gfx)) >> 1) -
+                     (fix_norm(*point_getX(pos)) + half);
+        *point_getAngle(ballPos) = angle_steer(offset, half, BAG_Cos(*point_getAngle(ballPos)), PADDLE_MIN_STEER, PADDLE_MAX_STEER);
+    }
 
     //update bullet if it is moving
-    p->Ball.update(&p->Ball, 0);
+    ballUpdate(&p->Ball, 0);
 
     if(extra != NULL)
         extra();
     //update player movement
-    pos->update(pos);
+    point_update(pos);
 }
 
-static void playerDraw(unsigned short *dest, Player_t *p){
-    //draw player sprite
-    GFXObj_t *gfx = p->gfx;
-    Point_t *pos = &p->Pos;
-
+static void playerAnimate(Player_t *p){
     //paddle animations
     if(!p->Ball.died){
         if(p->isBig)
@@ -274,12 +318,29 @@ static void playerDraw(unsigned short *dest, Player_t *p){
         else
             Animation_RunProfile(&p->Animations[SMALL_IDLE_ANIM]);
     }
+}
 
-    BAG_Display_SetGfxBlitXY(gfx, fix_norm(*pos->getX(pos)), fix_norm(*pos->getY(pos)));
-    BAG_Display_DrawObjSlowEx(gfx, dest, GAME_WIDTH, GAME_HEIGHT);
+//mark the cells the paddle and ball were drawn in last frame and will be drawn in now
+static void playerMarkDirty(DirtyMap_t *dirty, Player_t *p){
+    Point_t *pos = &p->Pos;
+    Dirty_MarkMoved(dirty, &p->drawn, fix_norm(*point_getX(pos)), fix_norm(*point_getY(pos)),
+                    *BAG_Display_GetGfxFrameWd(p->gfx), *BAG_Display_GetGfxFrameHt(p->gfx));
+
+    pos = &p->Ball.Pos;
+    Dirty_MarkMoved(dirty, &p->Ball.drawn, fix_norm(*point_getX(pos)), fix_norm(*point_getY(pos)),
+                    *BAG_Display_GetGfxFrameWd(p->Ball.gfx), *BAG_Display_GetGfxFrameHt(p->Ball.gfx));
+}
+
+static void playerDraw(const Surface_t *dest, Player_t *p){
+    //draw player sprite
+    GFXObj_t *gfx = p->gfx;
+    Point_t *pos = &p->Pos;
+
+    BAG_Display_SetGfxBlitXY(gfx, fix_norm(*point_getX(pos)), fix_norm(*point_getY(pos)));
+    SpanMask_Draw(p->mask, gfx, p->frame.frame, dest);
 
     //draw ball
-    p->Ball.draw(dest, &p->Ball);
+    ballDraw(dest, &p->Ball);
 }
 
 
@@ -292,11 +353,6 @@ void Player_Init(Player_t *p, GFXObj_t *sprite_gfx, GFXObj_t *ball_gfx){
     initPoint(&p->Pos);
     ballInit(&p->Ball, ball_gfx);
 
-    p->update = (void*)&playerUpdate;
-    p->draw = (void*)&playerDraw;
-    p->reset = (void*)playerReset;
-    p->resetPos = (void*)playerResetPos;
-
 
     //small idle anim
     {
@@ -338,188 +394,644 @@ void Player_Init(Player_t *p, GFXObj_t *sprite_gfx, GFXObj_t *ball_gfx){
         };
         memcpy(&p->Animations[DEATH_ANIM], &tempAnim, sizeof(AnimData));
     }
+    for(int i = 0; i < TOTAL_ANIM; i++)
+        p->Animations[i].cur = &p->frame;
     Animation_RunProfile(&p->Animations[SMALL_IDLE_ANIM]);
     playerReset(p);
 }
 
+const PlayerMethods_t Player_Methods = {
+    &playerUpdate, &playerAnimate, &playerMarkDirty, &playerDraw, &playerReset, &playerResetPos,
+};
+
 
 /*==========================================================================
 Invaders
 ==========================================================================*/
+//what a brick does when hit, indexed by tile value
+typedef struct BrickType_t{
+    int hp,//hits left, above 1 the brick becomes the tile before it
+        score;
+    char indestructible,
+         dropChance;//percent chance of a power-up when broken
+}BrickType_t;
+
+//read the brick types that go with a tile sheet, tiles not listed break in one hit
+static void BrickTypes_Load(BrickType_t *types, const char *file){
+    for(int i = 0; i < BRICK_TYPES_MAX; i++){
+        memset(&types[i], 0, sizeof(BrickType_t));
+        types[i].hp = 1;
+    }
+
+    FILE *fp = fopen(file, "r");
+    if(!fp){
+        printf("error loading brick types\n");
+        return;
+    }
+
+    char line[128];
+    while(fgets(line, sizeof(line), fp)){
+        int tile, hp, score, indestructible, drop;
+        if(line[0] == '#' || sscanf(line, "%d %d %d %d %d", &tile, &hp, &score, &indestructible, &drop) != 5)
+            continue;
+        if(tile <= 0 || tile >= BRICK_TYPES_MAX)
+            continue;
+        types[tile].hp = hp;
+        types[tile].score = score;
+        types[tile].indestructible = indestructible;
+        types[tile].dropChance = drop;
+    }
+    fclose(fp);
+}
+
 typedef struct Level_t{
-    TiledBG_t *gfx;
+    TileGrid_t *grid;
+    const LevelInfo_t *info;
+    const BrickType_t *types;
+    GFXObj_t *tiles,//tile sheet for drawing single bricks
+             *background,
+             *layer;//background with the bricks drawn on top
+    DirtyMap_t changed;//cells of layer that need composing again
     Point_t Pos;
-    void (*draw) (unsigned short *, struct Level_t *);
+    int bricks;//breakable bricks left
+    unsigned int rows[LEVEL_MAX_ROWS];//bit per column of the bricks left in each row
 }Level_t;
 
+typedef struct LevelMethods_t{
+    void (*draw) (unsigned short *, Level_t *);
+    void (*drawDirty) (unsigned short *, Level_t *, DirtyMap_t *);
+    void (*compose) (Level_t *);
+    void (*markTile) (DirtyMap_t *, Level_t *, unsigned char *);
+    void (*countBricks) (Level_t *);
+    void (*breakTile) (Level_t *, unsigned char *);
+}LevelMethods_t;
+
 
 static void levelDraw(unsigned short *dest, Level_t *a){
     Point_t *pos = &a->Pos;
-    BAG_TileBG_DrawBGEx(dest, a->gfx, fix_norm(*pos->getX(pos)), fix_norm(*pos->getY(pos)), GAME_WIDTH, GAME_HEIGHT);
+    TileGrid_t *bg = a->grid;
+    int x = fix_norm(*point_getX(pos)),
+        y = fix_norm(*point_getY(pos));
+
+    for(int ty = 0; ty < bg->height; ty++){
+        for(int tx = 0; tx < bg->width; tx++){
+            int tile = grid_getTile(bg, tx, ty);
+            if(tile > 0)
+                Dirty_DrawFrameClipped(a->tiles, tile - 1, dest, GAME_WIDTH, x + (tx << bg->divX), y + (ty << bg->divY),
+                                       0, 0, GAME_WIDTH, GAME_HEIGHT);
+        }
+    }
+}
+
+//redraw only the bricks overlapping dirty cells
+static void levelDrawDirty(unsigned short *dest, Level_t *a, DirtyMap_t *dirty){
+    Point_t *pos = &a->Pos;
+    TileGrid_t *bg = a->grid;
+    int x = fix_norm(*point_getX(pos)),
+        y = fix_norm(*point_getY(pos));
+
+    for(int row = 0; row < DIRTY_ROWS; row++){
+        unsigned int mask = dirty->rows[row];
+        for(int col = 0; mask; col++, mask >>= 1){
+            if(!(mask & 1))
+                continue;
+
+            int cX = col << DIRTY_CELL_DIVX,
+                cY = row << DIRTY_CELL_DIVY;
+            //bricks are not aligned to cells when the level is offset
+            for(int ty = (cY - y) >> bg->divY; ty <= (cY + DIRTY_CELL_HT - 1 - y) >> bg->divY; ty++){
+                if(ty < 0 || ty >= bg->height || !a->rows[ty])
+                    continue;
+                for(int tx = (cX - x) >> bg->divX; tx <= (cX + DIRTY_CELL_WD - 1 - x) >> bg->divX; tx++){
+                    int tile = grid_getTile(bg, tx, ty);
+                    if(tile <= 0)
+                        continue;
+                    Dirty_DrawFrameClipped(a->tiles, tile - 1, dest, GAME_WIDTH, x + (tx << bg->divX), y + (ty << bg->divY),
+                                           cX, cY, DIRTY_CELL_WD, DIRTY_CELL_HT);
+                }
+            }
+        }
+    }
+}
+
+//bring the changed cells of the cached layer up to date
+static void levelCompose(Level_t *a){
+    if(Dirty_IsEmpty(&a->changed))
+        return;
+
+    unsigned short *layer = BAG_Display_GetGfxBuf(a->layer);
+    //a skin without a background gets black behind the bricks
+    if(BAG_Display_GetGfxBuf(a->background) == NULL)
+        Dirty_Fill(&a->changed, layer, GAME_WIDTH, 0);
+    else
+        Dirty_Copy(&a->changed, 0, DIRTY_ROWS, layer, GAME_WIDTH, BAG_Display_GetGfxBuf(a->background),
+                   Sprite_Width(a->background), Sprite_Height(a->background));
+    levelDrawDirty(layer, a, &a->changed);
+    Dirty_Clear(&a->changed);
+}
+
+//mark the cells covered by a brick that changed, on screen and in the cached layer
+static void levelMarkTile(DirtyMap_t *dirty, Level_t *a, unsigned char *tile){
+    Point_t *pos = &a->Pos;
+    TileGrid_t *bg = a->grid;
+    int index = tile - bg->tiles,
+        x = fix_norm(*point_getX(pos)) + ((index % bg->width) << bg->divX),
+        y = fix_norm(*point_getY(pos)) + ((index / bg->width) << bg->divY);
+
+    Dirty_MarkRect(dirty, x, y, bg->tileWd, bg->tileHt);
+    Dirty_MarkRect(&a->changed, x, y, bg->tileWd, bg->tileHt);
 }
 
-void Level_Init(Level_t *a, TiledBG_t *bg){
+//rebuild the brick count and row masks when a level (re)starts, from what the
+//level compiler counted and only the rows it says have bricks
+static void levelCountBricks(Level_t *a){
+    TileGrid_t *bg = a->grid;
+    const LevelInfo_t *info = a->info;
+    a->bricks = 0;
+    memset(a->rows, 0, sizeof(a->rows));
+
+    for(int tile = 1; tile < info->types; tile++){
+        if(!a->types[tile & (BRICK_TYPES_MAX - 1)].indestructible)
+            a->bricks += info->histogram[tile];
+    }
+
+    for(int y = info->firstRow; y <= info->lastRow && y < LEVEL_MAX_ROWS; y++){
+        for(int x = 0; x < bg->width && x < LEVEL_MAX_COLS; x++){
+            if(grid_getTile(bg, x, y) > 0)
+                a->rows[y] |= 1u << x;
+        }
+    }
+}
+
+//a brick was destroyed, take it off the count
+static void levelBreakTile(Level_t *a, unsigned char *tile){
+    TileGrid_t *bg = a->grid;
+    int index = tile - bg->tiles,
+        x = index % bg->width,
+        y = index / bg->width;
+
+    if(y < LEVEL_MAX_ROWS && x < LEVEL_MAX_COLS && (a->rows[y] & (1u << x))){
+        a->rows[y] &= ~(1u << x);
+        a->bricks--;
+    }
+}
+
+void Level_Init(Level_t *a, TileGrid_t *grid, const LevelInfo_t *info, const BrickType_t *types, GFXObj_t *tiles, GFXObj_t *background, GFXObj_t *layer){
     memset(a, 0, sizeof(Level_t));
-    a->gfx = bg;
+    a->grid = grid;
+    a->info = info;
+    a->types = types;
+    a->tiles = tiles;
+    a->background = background;
+    a->layer = layer;
     initPoint(&a->Pos);
-
-    a->draw = (void*)&levelDraw;
+    Dirty_MarkAll(&a->changed);
 }
 
+const LevelMethods_t Level_Methods = {
+    &levelDraw, &levelDrawDirty, &levelCompose, &levelMarkTile, &levelCountBricks, &levelBreakTile,
+};
+
 /*==========================================================================
 Logic
 ==========================================================================*/
-TiledBG_t level_tiles = {0};//aliens tiled background
+static GAME_LOCAL LevelPack_t LevelPack;//every level, index read once at start up
+static GAME_LOCAL LevelMap_t LevelFile;//level file and the brick grid in play
+static GAME_LOCAL LevelMap_t NextLevelFile;//level after it, read in during play
+static GAME_LOCAL LevelFetch_t NextFetch = {-1};
+static GAME_LOCAL int CurLevel = -1, NextLevel = -1;//index in the level pack
+static GAME_LOCAL char FirstLevel[MAX_PATH], GameSkin[MAX_PATH];//what Game_Restart goes back to
 
 static GFXObj_t Canvas,//main buffer to blit to
+                LevelLayer;//background and bricks, only redrawn where bricks change
+static GAME_LOCAL GFXObj_t BrickTiles,
                 Paddle,
                 Ball,
                 Background,
                 PowerUps;
+static GAME_LOCAL Skin_t *TileSkin, *GfxSkin;//what the views above point into, held in the skin cache
+static GAME_LOCAL SpanMask_t PaddleMask, BallMask;//opaque runs for the span blitter
+
 
+static GAME_LOCAL Player_t Player = {0};
+static GAME_LOCAL Level_t Level = {0};
+static GAME_LOCAL BrickType_t BrickTypes[BRICK_TYPES_MAX];//loaded with the brick tiles
+static GAME_LOCAL char BrickTypesSkin[MAX_PATH];//skin BrickTypes was read from
+static GAME_LOCAL BallPool_t ExtraBalls;//multiball
 
-static Player_t Player = {0};
-static Level_t Level = {0};
+static GAME_LOCAL GameStats_t Stats;
+static GAME_LOCAL int AllDown;//every ball was gone at the end of the last step, an int for the history
+
+//pad recorded each step, and a recording being played back instead of the pad
+static GAME_LOCAL Replay_t Recording, Playback;
+static GAME_LOCAL char IsRecording, IsReplaying;
+static GAME_LOCAL unsigned long Mismatches, FirstMismatch;
+static GAME_LOCAL unsigned int BrickHash;//every brick hit so far, cheaper than hashing the grid each step
+
+//a capture of the game every step once rewinding is enabled, holding Y goes back through them
+static GAME_LOCAL Snapshot_t History;
+#define REWIND_BYTES (2 << 20)
+
+//cells to redraw this frame, and the ones flipped last frame
+static GAME_LOCAL DirtyMap_t Dirty, LastFlipped;
 
 
 /*
 Bullet collision for the players shot
 -need to add bunker collisions
 */
-static char processTile(unsigned int *tile){
+static char processTile(unsigned char *tile){
     if(!tile || *tile == 0)//tile is dead
         return 0;
 
-    //gold tiles take 4 hits to break and silver tiles 2
-    if(*tile == 14 || *tile == 13 || *tile == 12 || *tile == 10){
+    const BrickType_t *type = &Level.types[*tile & (BRICK_TYPES_MAX - 1)];
+    if(type->indestructible)
+        return 1;
+
+    levelMarkTile(&Dirty, &Level, tile);
+    LevelMap_Touch(&LevelFile, tile);
+    int hit = tile - LevelFile.grid.tiles;
+    BrickHash = Replay_Hash(BrickHash, &hit, 1);
+    if(type->hp > 1){
         (*tile)--;
         return 1;
     }
+    Player.score += type->score;
     *tile = 0;
+    levelBreakTile(&Level, tile);
+    Stats.bricks++;
     return 1;
 }
 
 
 static void BallBrickCollision(void){
-    //get alien information
-    Point_t *aPos = &Level.Pos;
-    TiledBG_t *aGfx = Level.gfx;
-
-    unsigned int *tiles[4][3];
-    int flags = obj_collisionTile_Pt(&Player.Ball.Pos, Player.ball_gfx, aPos, aGfx, tiles);
-    for(int i = 0; i < 3; i++){
-        if(GET_FLAG(flags, COLLISION_UP)){
-            if(processTile(tiles[0][i])){
-                *Player.Ball.Pos.getAngle(&Player.Ball.Pos) = angle_vertFlip(*Player.Ball.Pos.getAngle(&Player.Ball.Pos));
-                break;
-            }
-        }
-        else if(GET_FLAG(flags, COLLISION_DOWN)){
-            if(processTile(tiles[1][i])){
-                *Player.Ball.Pos.getAngle(&Player.Ball.Pos) = angle_vertFlip(*Player.Ball.Pos.getAngle(&Player.Ball.Pos));
-                break;
-            }
-        }
+    PROFILE_BEGIN(PROFILE_COLLISION);
+    Ball_t *ball = &Player.Ball;
+    Point_t *pos = &ball->Pos;
+    if(ball->died){
+        PROFILE_END(PROFILE_COLLISION);
+        return;
+    }
 
-        if(GET_FLAG(flags, COLLISION_LEFT)){
-            if(processTile(tiles[2][i])){
-                *Player.Ball.Pos.getAngle(&Player.Ball.Pos) = angle_horFlip(*Player.Ball.Pos.getAngle(&Player.Ball.Pos));
-                break;
-            }
-        }
-        else if(GET_FLAG(flags, COLLISION_RIGHT)){
-            if(processTile(tiles[3][i])){
-                *Player.Ball.Pos.getAngle(&Player.Ball.Pos) = angle_horFlip(*Player.Ball.Pos.getAngle(&Player.Ball.Pos));
-                break;
-            }
-        }
+    //sweep the ball along this frame's movement and stop it at the first brick
+    TileHit_t hit;
+    int dy = *point_getY(pos) - ball->lastY;
+    if(!obj_sweepRowsOccupied(ball->lastY, *BAG_Display_GetGfxFrameHt(ball->gfx), dy, &Level.Pos, Level.grid, Level.rows)){
+        PROFILE_END(PROFILE_COLLISION);
+        return;
     }
 
+    int flags = obj_sweepTile(ball->lastX, ball->lastY, *BAG_Display_GetGfxFrameWd(ball->gfx), *BAG_Display_GetGfxFrameHt(ball->gfx),
+                              *point_getX(pos) - ball->lastX, dy, &Level.Pos, Level.grid, &hit);
+    if(flags && processTile(hit.tile)){
+        *point_getX(pos) = hit.x;
+        *point_getY(pos) = hit.y;
+        if(GET_FLAG(flags, COLLISION_UP | COLLISION_DOWN))
+            point_flipVert(pos);
+        if(GET_FLAG(flags, COLLISION_LEFT | COLLISION_RIGHT))
+            point_flipHor(pos);
+    }
+    PROFILE_END(PROFILE_COLLISION);
 }
 
 
 
+static void ExtraBallUpdate(void){
+    PROFILE_BEGIN(PROFILE_BALL_POOL);
+    BallPool_PaddleCollision(&ExtraBalls, &Player.Pos, Player.gfx, PADDLE_MIN_STEER, PADDLE_MAX_STEER);
+    BallPool_Update(&ExtraBalls);
+    BallPool_BrickCollision(&ExtraBalls, &Level.Pos, Level.grid, Level.rows, &processTile);
+    PROFILE_END(PROFILE_BALL_POOL);
+
+    //a life is only lost once every ball is gone
+    int x, y, speed, angle;
+    if(Player.Ball.died && BallPool_Take(&ExtraBalls, &x, &y, &speed, &angle)){
+        ballLaunch(&Player.Ball, speed, angle);
+        *point_getX(&Player.Ball.Pos) = Player.Ball.lastX = x;
+        *point_getY(&Player.Ball.Pos) = Player.Ball.lastY = y;
+    }
+}
+
+#ifdef DEBUG_MULTIBALL
+//split every ball in play into three
+static void Multiball(void){
+    Ball_t *ball = &Player.Ball;
+    Point_t *pos = &ball->Pos;
+    if(ball->died || *point_getSpeed(pos) == 0)
+        return;
+
+    BallPool_Split(&ExtraBalls, MULTIBALL_SPREAD);
+    BallPool_Spawn(&ExtraBalls, *point_getX(pos), *point_getY(pos), *point_getSpeed(pos), *point_getAngle(pos) + MULTIBALL_SPREAD);
+    BallPool_Spawn(&ExtraBalls, *point_getX(pos), *point_getY(pos), *point_getSpeed(pos), *point_getAngle(pos) - MULTIBALL_SPREAD);
+}
+#endif
+
+static void BallCollisions(void){
+    BallBrickCollision();
+    ExtraBallUpdate();
+}
+
 //check if level complete
-static char levelCompleted(TiledBG_t *bg){
-    //scan through ever tile to see if they have been destroyed
-    for(int x = 0; x < bg->width; x++){
-        for(int y = 0; y < bg->height; y++){
-            if(BAG_TileBG_GetTile(bg, x, y) > 0)
-                return 0;
-        }
+static char levelCompleted(Level_t *level){
+    return level->bricks <= 0;
+}
+
+
+
+
+//bricks are tracked a bit per column of each row, a level any bigger could never be cleared
+static int levelFits(LevelMap_t *map){
+    if(map->grid.width <= LEVEL_MAX_COLS && map->grid.height <= LEVEL_MAX_ROWS)
+        return 1;
+    printf("level is too big, %dx%d is more than %dx%d\n", map->grid.width, map->grid.height, LEVEL_MAX_COLS, LEVEL_MAX_ROWS);
+    LevelMap_Close(map);
+    return 0;
+}
+
+//from the level pack when it has the level, otherwise the loose file in the levels folder
+static int openLevel(LevelMap_t *map, const char *level){
+    int index = LevelPack_Find(&LevelPack, level);
+    if(index >= 0){
+        unsigned long length;
+        int owned;
+        const unsigned char *data = LevelPack_Read(&LevelPack, index, &length, &owned);
+        return data && LevelMap_OpenMem(map, data, length, owned) && levelFits(map);
     }
-    return 1;
+
+    char path[MAX_PATH];
+    sprintf(path, "%s%s%s", RootDir, LevelDir, level);
+    return LevelMap_Open(map, path) && levelFits(map);
+}
+
+//start reading the level after the current one while this one is played
+static void prefetchNextLevel(void){
+    LevelPack_FetchCancel(&NextFetch);
+    LevelMap_Close(&NextLevelFile);
+    NextLevel = -1;
+    if(CurLevel >= 0)
+        LevelPack_FetchStart(&LevelPack, &NextFetch, (CurLevel + 1) % LevelPack.count);
+}
+
+//read a chunk more of the next level, it is made ready to play as soon as it is all in
+static void updatePrefetch(unsigned long chunk){
+    if(NextFetch.level < 0)
+        return;
+
+    int state = LevelPack_FetchStep(&LevelPack, &NextFetch, chunk);
+    if(state == 0)
+        return;
+    if(state > 0){
+        if(!LevelMap_OpenMem(&NextLevelFile, NextFetch.data, NextFetch.length, NextFetch.owned))
+            printf("error loading next level\n");
+        else if(levelFits(&NextLevelFile))
+            NextLevel = NextFetch.level;
+        NextFetch.buf = NULL;//the level map has it now
+    }
+    LevelPack_FetchCancel(&NextFetch);
+}
+
+//fields of a struct from first up to end
+static int historyAddFields(void *first, void *end){
+    return Snapshot_AddRegion(&History, first, (char *)end - (char *)first);
 }
 
+//everything a step changes, from the start of the level in play, rewinding stops there.
+//a history missing any of it could only rewind part of the game, so it is dropped
+static int historyStart(void){
+    if(!History.ring)
+        return 0;
 
+    Snapshot_Reset(&History);
+    //where things were drawn is left out, a rewind redraws everything
+    int ok = Snapshot_AddRegion(&History, &Player.Pos, sizeof(Point_t));
+    ok &= historyAddFields(&Player.Ball.Pos, &Player.Ball.drawn);//the last position and died too
+    for(int i = 0; i < TOTAL_ANIM; i++){
+        AnimData *anim = &Player.Animations[i];
+        ok &= historyAddFields(&anim->loop, &anim->loopIncrement + 1);//done and the loop counters
+    }
+    ok &= Snapshot_AddRegion(&History, &Player.frame, sizeof(AnimFrame_t));
+    ok &= historyAddFields(&Player.score, &Player.isBig + 1);
+    //the paddle's frame is put back from Player.frame, the rest of the animation is set here
+    ok &= Snapshot_AddRegion(&History, BAG_Display_GetGfxOffsetY(&Paddle), sizeof(int));
+    ok &= Snapshot_AddRegion(&History, BAG_Display_GetGfxFrameWd(&Paddle), sizeof(int));
+    ok &= Snapshot_AddRegion(&History, BAG_Display_GetGfxFrameHt(&Paddle), sizeof(int));
+    //only the balls in use, their last positions are set again every step
+    ok &= Snapshot_AddRegion(&History, &ExtraBalls.count, sizeof(ExtraBalls.count));
+    ok &= Snapshot_AddArray(&History, ExtraBalls.x, sizeof(int), BALL_POOL_MAX, &ExtraBalls.count);
+    ok &= Snapshot_AddArray(&History, ExtraBalls.y, sizeof(int), BALL_POOL_MAX, &ExtraBalls.count);
+    ok &= Snapshot_AddArray(&History, ExtraBalls.vx, sizeof(int), BALL_POOL_MAX, &ExtraBalls.count);
+    ok &= Snapshot_AddArray(&History, ExtraBalls.vy, sizeof(int), BALL_POOL_MAX, &ExtraBalls.count);
+    ok &= Snapshot_AddArray(&History, ExtraBalls.speed, sizeof(int), BALL_POOL_MAX, &ExtraBalls.count);
+    ok &= Snapshot_AddArray(&History, ExtraBalls.angle, sizeof(short), BALL_POOL_MAX, &ExtraBalls.count);
+    ok &= Snapshot_AddArray(&History, ExtraBalls.alive, sizeof(char), BALL_POOL_MAX, &ExtraBalls.count);
+    ok &= Snapshot_AddRegion(&History, &Level.bricks, sizeof(Level.bricks));
+    ok &= Snapshot_AddRegion(&History, Level.rows, sizeof(Level.rows));
+    ok &= Snapshot_AddRegion(&History, &Stats, sizeof(GameStats_t));
+    ok &= Snapshot_AddRegion(&History, &AllDown, sizeof(AllDown));
+    ok &= Snapshot_AddRegion(&History, &BrickHash, sizeof(BrickHash));
+    if(LevelFile.grid.tiles)
+        ok &= Snapshot_AddRegion(&History, LevelFile.grid.tiles, LevelFile.grid.width * LevelFile.grid.height);
+
+    if(!ok){
+        printf("rewind history can not hold all of the game\n");
+        Snapshot_Free(&History);
+        return 0;
+    }
+    Snapshot_Capture(&History);
+    return 1;
+}
 
+#ifdef DEBUG_REWIND
+//go back a step, nothing moves once the history runs out
+static void rewindStep(void){
+    if(!Snapshot_Rewind(&History, 1))
+        return;
+    BAG_Display_SetObjFrame(Player.gfx, FRAME_HOR, Player.frame.frame);
+    //whatever was drawn since is wrong now
+    Dirty_MarkAll(&Dirty);
+    Dirty_MarkAll(&Level.changed);
+}
+#endif
+
+//hold the skin views are about to point into and let go of the one they pointed into,
+//on failure the old views and their hold stay as they were
+static Skin_t *holdSkin(Skin_t **held, const char *curSkin){
+    char path[MAX_PATH];
+    sprintf(path, "%s%s", RootDir, SkinDir);
+    Skin_t *skin = SkinCache_Get(path, curSkin);
+    if(!skin)
+        return NULL;
+
+    SkinCache_Hold(skin);
+    if(*held)
+        SkinCache_Release(*held);
+    *held = skin;
+    return skin;
+}
 
 void loadLevel(const char *curSkin, const char *level){
-    char path[MAX_PATH<<1];
+    char path[MAX_PATH];
     memset(&path, 0, sizeof(path));
 
-    sprintf(path, "%s%s%s", RootDir, LevelDir, level);
-    path[MAX_PATH] = '\0';
+    //brick types only change with the skin
+    if(strcmp(BrickTypesSkin, curSkin)){
+        sprintf(path, "%s%s%s/brickTiles.txt", RootDir, SkinDir, curSkin);
+        BrickTypes_Load(BrickTypes, path);
+        snprintf(BrickTypesSkin, sizeof(BrickTypesSkin), "%s", curSkin);
+    }
 
-    sprintf(&path[MAX_PATH+1], "%s%s%s/brickTiles", RootDir, SkinDir, curSkin);
-    if(!BAG_TileBG_LoadBG(&path[MAX_PATH+1], path, &level_tiles))
+    LevelMap_Close(&LevelFile);
+    if(!openLevel(&LevelFile, level))
         printf("error loading level\n");
-    BAG_TileBG_SetProperties(&level_tiles, GAME_HEIGHT >> level_tiles.divY, GAME_WIDTH >> level_tiles.divX, 0, 0);
+    CurLevel = LevelPack_Find(&LevelPack, level);
+    prefetchNextLevel();
     //Invaders.forceMode = 1;
+
+    //tile sheet the bricks are drawn from
+    Skin_t *skin = holdSkin(&TileSkin, curSkin);
+    if(skin)
+        SkinCache_ViewSheet(&skin->bricks, &BrickTiles);
+    else
+        printf("error loading brick tiles\n");
+    BAG_Display_SetGfxFrameDim(&BrickTiles, LevelFile.grid.tileWd, LevelFile.grid.tileHt);
+    levelCountBricks(&Level);
+    Dirty_MarkAll(&Dirty);
+    Dirty_MarkAll(&Level.changed);
+    historyStart();
+}
+
+//put back every brick of the current level without reading it again
+void restartLevel(void){
+    LevelMap_Reset(&LevelFile);
+    levelCountBricks(&Level);
+    Dirty_MarkAll(&Dirty);
+    Dirty_MarkAll(&Level.changed);
+    historyStart();
 }
 
+//swap in the prefetched level, levels outside the pack just start over
+void nextLevel(void){
+    //not all in yet, finish it now
+    updatePrefetch(~0ul);
+    if(NextLevel < 0){
+        restartLevel();
+        return;
+    }
+
+    LevelMap_t old = LevelFile;
+    LevelFile = NextLevelFile;
+    NextLevelFile = old;
+    LevelMap_Close(&NextLevelFile);
+    CurLevel = NextLevel;
+
+    //the next level may use another tile size
+    BAG_Display_SetGfxFrameDim(&BrickTiles, LevelFile.grid.tileWd, LevelFile.grid.tileHt);
+    levelCountBricks(&Level);
+    Dirty_MarkAll(&Dirty);
+    Dirty_MarkAll(&Level.changed);
+    BallPool_Init(&ExtraBalls, ExtraBalls.gfx, ExtraBalls.mask);
+    playerResetPos(&Player);
+    prefetchNextLevel();
+    historyStart();
+}
+
+//the graphics are views into the skin cache, so they are never deleted here
 void LoadGraphics(const char *curSkin){
-    char path[MAX_PATH];
-    memset(path, 0, sizeof(path));
+    Skin_t *skin = holdSkin(&GfxSkin, curSkin);
+    if(!skin){
+        printf("error loading skin %s\n", curSkin);
+        return;
+    }
 
-    sprintf(path, "%s%s%s/paddle", RootDir, SkinDir, curSkin);
-    if(BAG_Display_LoadObjExt(path, &Paddle) != NO_ERR)
-        printf("error loading paddle\n");
+    SkinCache_View(skin, SKIN_PADDLE, &Paddle);
     //BAG_Display_SetGfxFrameDim(&Paddle, 36, 12);
+    SkinCache_View(skin, SKIN_BALL, &Ball);
+    //BAG_Display_SetGfxFrameDim(&Bullets, 4, 7);
+    SkinCache_View(skin, SKIN_POWERUPS, &PowerUps);
+    SkinCache_ViewSheet(&skin->background, &Background);
+}
 
+//paddle frames come from its animations, so this follows Player_Init
+static void buildSpanMasks(void){
+    SpanMask_Free(&PaddleMask);
+    SpanMask_Free(&BallMask);
 
-    sprintf(path, "%s%s%s/ball", RootDir, SkinDir, curSkin);
-    if(BAG_Display_LoadObjExt(path, &Ball) != NO_ERR)
-        printf("error loading ball\n");
-    //BAG_Display_SetGfxFrameDim(&Bullets, 4, 7);
+    for(int i = 0; i < TOTAL_ANIM; i++){
+        AnimData *anim = &Player.Animations[i];
+        int frames = ((anim->lastFrame > anim->idleFrame) ? anim->lastFrame : anim->idleFrame) + 1;
+        if(!SpanMask_AddStrip(&PaddleMask, &Paddle, anim->verticalOffset, anim->frameWd, anim->frameHt, frames))
+            printf("no span mask for paddle animation %d\n", i);
+    }
+    if(!SpanMask_AddStrip(&BallMask, &Ball, *BAG_Display_GetGfxOffsetY(&Ball), *BAG_Display_GetGfxFrameWd(&Ball),
+                          *BAG_Display_GetGfxFrameHt(&Ball), 1))
+        printf("no span mask for the ball\n");
 
-    sprintf(path, "%s%s%s/background", RootDir, SkinDir, curSkin);
-    if(BAG_Display_LoadObjExt(path, &Background) != NO_ERR)
-        printf("error loading background\n");
+    Player.mask = &PaddleMask;
+    Player.Ball.mask = &BallMask;
 }
 
 
 
 
-void Flip_Screen(GFXObj_t *screen){
-    BAG_Display_SetGfxFrameDim(screen, SCREEN_WIDTH, SCREEN_HEIGHT);
+//copy the cells of a game sized buffer that changed since the back buffers last had them
+static void copyToScreens(const unsigned short *buf){
+    //screens are double buffered, so the back buffers are missing last frame's changes too
+    DirtyMap_t flip;
+    Dirty_Union(&flip, &Dirty, &LastFlipped);
+    memcpy(&LastFlipped, &Dirty, sizeof(DirtyMap_t));
 
-    //set top screen
-    BAG_Display_SetObjFrame(screen, FRAME_VERT, 0);
-    BAG_Display_DrawObjFast(screen, up_screen_addr, 0, 0);
-
-    //set top screen
-    BAG_Display_SetObjFrame(screen, FRAME_VERT, 1);
-    BAG_Display_DrawObjFast(screen, down_screen_addr, 0, 0);
+    //top screen
+    Dirty_Copy(&flip, 0, DIRTY_ROWS >> 1, up_screen_addr, SCREEN_WIDTH, buf, GAME_WIDTH, GAME_HEIGHT);
+    //bottom screen
+    Dirty_Copy(&flip, DIRTY_ROWS >> 1, DIRTY_ROWS, down_screen_addr, SCREEN_WIDTH, buf, GAME_WIDTH, GAME_HEIGHT);
+}
 
-    BAG_Display_SetGfxFrameDim(screen, GAME_WIDTH, GAME_HEIGHT);
+void Flip_Screen(GFXObj_t *screen){
+    #ifndef DRAW_TO_SCREENS
+        copyToScreens(BAG_Display_GetGfxBuf(screen));
+    #endif
     //flip screens
     ds2_flipScreen(DUAL_SCREEN, 1);
 }
 
 
 void DrawScreen(GFXObj_t *screen){
-    unsigned short *Screen_Buffer = BAG_Display_GetGfxBuf(screen);
-    if(Screen_Buffer == NULL){
+    #ifdef DRAW_TO_SCREENS
+        Surface_t surface = {{up_screen_addr, down_screen_addr}, SCREEN_HEIGHT};
+    #else
+        Surface_t surface = {{BAG_Display_GetGfxBuf(screen), NULL}, GAME_HEIGHT};
+    #endif
+    if(surface.half[0] == NULL){
         printf("screen buffer error!\n");
         while(1);
     }
-    BAG_Display_DrawObjFastEx(&Background, Screen_Buffer, GAME_WIDTH, GAME_HEIGHT);
-
-
-    Level.draw(Screen_Buffer, &Level);
-    Player.draw(Screen_Buffer, &Player);
-    Flip_Screen(&Canvas);
+    playerMarkDirty(&Dirty, &Player);
+    BallPool_MarkDirty(&Dirty, &ExtraBalls);
+
+    //update the cached level layer where bricks were hit
+    PROFILE_BEGIN(PROFILE_LEVEL_DRAW);
+    levelCompose(&Level);
+    PROFILE_END(PROFILE_LEVEL_DRAW);
+
+    //restore background and bricks under everything that changed
+    PROFILE_BEGIN(PROFILE_BACKGROUND);
+    #ifdef DRAW_TO_SCREENS
+        copyToScreens(BAG_Display_GetGfxBuf(&LevelLayer));
+    #else
+        Dirty_Copy(&Dirty, 0, DIRTY_ROWS, surface.half[0], GAME_WIDTH, BAG_Display_GetGfxBuf(&LevelLayer), GAME_WIDTH, GAME_HEIGHT);
+    #endif
+    PROFILE_END(PROFILE_BACKGROUND);
+
+    //everything on top is drawn again each frame, so whatever was under it is restored above
+    PROFILE_BEGIN(PROFILE_PLAYER_DRAW);
+    playerDraw(&surface, &Player);
+    BallPool_Draw(&surface, &ExtraBalls);
+    PROFILE_END(PROFILE_PLAYER_DRAW);
+
+    PROFILE_BEGIN(PROFILE_FLIP);
+    Flip_Screen(screen);
+    PROFILE_END(PROFILE_FLIP);
+    Dirty_Clear(&Dirty);
 }
 
 
@@ -529,40 +1041,277 @@ void DrawScreen(GFXObj_t *screen){
 Back to normal programming stuff
 */
 void update(void){
-    Player.update(&Player, &BallBrickCollision);
+    PROFILE_BEGIN(PROFILE_PLAYER_UPDATE);
+#ifdef DEBUG_MULTIBALL
+    //R splits the balls in play, only for testing with many balls
+    if(Pad.Newpress.R)
+        Multiball();
+#endif
+
+    playerUpdate(&Player, &BallCollisions);
+    PROFILE_END(PROFILE_PLAYER_UPDATE);
+
+    Stats.steps++;
+    char down = Player.Ball.died && !BallPool_Live(&ExtraBalls);
+    if(down && !AllDown)
+        Stats.livesLost++;
+    AllDown = down;
+    Stats.over = down && Player.lives <= 0;
+    Stats.score = Player.score;
+
+    if(levelCompleted(&Level)){
+        Stats.levels++;
+        if(!Stats.clearedAt)
+            Stats.clearedAt = Stats.steps;
+        nextLevel();
+    }
+}
+
+
+//everything a step changes, hashed so a replay can show it plays out the same
+unsigned int Game_Hash(void){
+    Ball_t *ball = &Player.Ball;
+    int state[] = {
+        Player.Pos.x, Player.Pos.y, Player.Pos.speed, Player.Pos.angle,
+        ball->Pos.x, ball->Pos.y, ball->Pos.speed, ball->Pos.angle, ball->lastX, ball->lastY, ball->died,
+        Player.lives, Player.score, Player.isBig, Level.bricks, CurLevel, BrickHash, ExtraBalls.count,
+        Player.frame.frame, *BAG_Display_GetGfxOffsetY(Player.gfx),
+        *BAG_Display_GetGfxFrameWd(Player.gfx), *BAG_Display_GetGfxFrameHt(Player.gfx),
+    };
+    unsigned int hash = Replay_Hash(REPLAY_HASH_SEED, state, sizeof(state) / sizeof(int));
+
+    for(int i = 0; i < TOTAL_ANIM; i++){
+        AnimData *anim = &Player.Animations[i];
+        int timers[] = {anim->done, anim->loopTimes, anim->loopIncrement};
+        hash = Replay_Hash(hash, timers, sizeof(timers) / sizeof(int));
+    }
+    for(int i = 0; i < ExtraBalls.count; i++){
+        if(!ExtraBalls.alive[i])
+            continue;
+        int balls[] = {i, ExtraBalls.x[i], ExtraBalls.y[i], ExtraBalls.vx[i], ExtraBalls.vy[i]};
+        hash = Replay_Hash(hash, balls, sizeof(balls) / sizeof(int));
+    }
+    return hash;
+}
+
+//one step on the pad, or on the next step of the replay
+static void runStep(void){
+    unsigned int mask, last = Playback.mask, hash = 0;
+    if(IsReplaying && Replay_Next(&Playback, &mask, &hash))
+        Replay_MaskToPad(mask, last, &Pad);
+
+#ifdef DEBUG_REWIND
+    //holding Y goes back through the history, only for testing
+    if(Pad.Held.Y)
+        rewindStep();
+    else
+#endif
+    {
+        update();
+        //animations move on with the game, not with how often it is drawn
+        playerAnimate(&Player);
+        PROFILE_BEGIN(PROFILE_SNAPSHOT);
+        Snapshot_Capture(&History);
+        PROFILE_END(PROFILE_SNAPSHOT);
+    }
+    if(IsRecording && !Replay_Record(&Recording, Replay_PadToMask(&Pad), Game_Hash())){
+        printf("out of memory recording step %lu\n", Recording.steps);
+        IsRecording = 0;
+    }
+    if(IsReplaying && Playback.hashes && hash != Game_Hash()){
+        if(!Mismatches++)
+            FirstMismatch = Playback.step;
+    }
+}
+
+void Game_Record(void){
+    Replay_Free(&Recording);
+    IsRecording = 1;
+}
+
+int Game_SaveRecording(const char *file){
+    return Replay_Save(&Recording, file);
+}
+
+unsigned long Game_Recorded(void){
+    return Recording.steps;
+}
+
+int Game_Replay(const char *file){
+    Replay_Free(&Playback);
+    Mismatches = FirstMismatch = 0;
+    IsReplaying = Replay_Load(&Playback, file) == REPLAY_OK;
+    return IsReplaying;
+}
+
+int Game_EnableRewind(unsigned long bytes){
+    if(!History.ring && !Snapshot_Init(&History, bytes))
+        return 0;
+    return historyStart();
+}
+
+char Game_ReplayDone(void){
+    return IsReplaying && Playback.step >= Playback.steps;
+}
+
+unsigned long Game_ReplayResult(unsigned long *mismatches, unsigned long *firstMismatch){
+    *mismatches = Mismatches;
+    *firstMismatch = FirstMismatch;
+    return Playback.step;
+}
+
+/*==========================================================================
+Headless play, the game without any drawing
+==========================================================================*/
+int Game_Init(const char *skin, const char *level){
+    //the level layer is only needed for drawing, headless games share the empty one
+    Level_Init(&Level, &LevelFile.grid, &LevelFile.info, BrickTypes, &BrickTiles, &Background, &LevelLayer);
+
+    char pack[MAX_PATH];
+    sprintf(pack, "%s%s", RootDir, LevelPackFile);
+    if(!LevelPack_Open(&LevelPack, pack))
+        printf("no level pack, loading levels from %s\n", LevelDir);
+    snprintf(GameSkin, sizeof(GameSkin), "%s", skin);
+    snprintf(FirstLevel, sizeof(FirstLevel), "%s", level);
+    loadLevel(GameSkin, FirstLevel);
+    LoadGraphics(GameSkin);
+    if(!LevelFile.grid.tiles || !BAG_Display_GetGfxBuf(&Paddle))
+        return 0;
+
+    Player_Init(&Player, &Paddle, &Ball);
+    buildSpanMasks();
+    BallPool_Init(&ExtraBalls, &Ball, &BallMask);
+    memset(&Stats, 0, sizeof(GameStats_t));
+    AllDown = 0;
+    return 1;
+}
+
+//the level starts the history, so everything else is reset before it
+void Game_Restart(void){
+    BallPool_Init(&ExtraBalls, ExtraBalls.gfx, ExtraBalls.mask);
+    playerReset(&Player);
+    memset(&Stats, 0, sizeof(GameStats_t));
+    AllDown = 0;
+    if(CurLevel >= 0 && CurLevel == LevelPack_Find(&LevelPack, FirstLevel))
+        restartLevel();
+    else
+        loadLevel(GameSkin, FirstLevel);
+}
+
+void Game_Step(void){
+    runStep();
+}
+
+//nothing is left pointing at what was freed, Game_Init can start over
+void Game_Free(void){
+    LevelPack_FetchCancel(&NextFetch);
+    LevelMap_Close(&LevelFile);
+    LevelMap_Close(&NextLevelFile);
+    LevelPack_Close(&LevelPack);
+    CurLevel = NextLevel = -1;
+    SpanMask_Free(&PaddleMask);
+    SpanMask_Free(&BallMask);
+    TileSkin = GfxSkin = NULL;
+    SkinCache_Flush();
+    BrickTypesSkin[0] = '\0';
+    Snapshot_Free(&History);
+    Replay_Free(&Recording);
+    Replay_Free(&Playback);
+    IsRecording = IsReplaying = 0;
+}
+
+const GameStats_t *Game_Stats(void){
+    return &Stats;
+}
+
+void Game_View(GameView_t *view){
+    view->paddleX = fix_norm(*point_getX(&Player.Pos));
+    view->paddleWd = *BAG_Display_GetGfxFrameWd(Player.gfx);
+    view->ballX = fix_norm(*point_getX(&Player.Ball.Pos));
+    view->ballY = fix_norm(*point_getY(&Player.Ball.Pos));
+    view->ballWd = *BAG_Display_GetGfxFrameWd(Player.Ball.gfx);
+    view->ballMoving = !Player.Ball.died && *point_getSpeed(&Player.Ball.Pos) != 0;
+    view->ballReady = *point_getSpeed(&Player.Ball.Pos) == 0 || (Player.Ball.died && Player.Animations[SPAWN_ANIM].done);
 }
 
 
 
+//or the presses or releases of one frame into those still waiting for a step
+static void buttonsOr(PadButtons_t *to, const PadButtons_t *from){
+    unsigned char *a = (unsigned char*)to;
+    const unsigned char *b = (const unsigned char*)from;
+    for(unsigned int i = 0; i < sizeof(PadButtons_t); i++)
+        a[i] |= b[i];
+}
+
 void ds2_main(void){
+    PROFILE_STARTUP_BEGIN();
     if(!BAG_Init(1))
         ds2_plug_exit();
 
     BAG_Core_SetFPS(120);
     ds2_setCPUclocklevel(13);
     //play area
-    BAG_Display_CreateObj(&Canvas, 16, GAME_WIDTH, GAME_HEIGHT, GAME_WIDTH, GAME_HEIGHT);
+    #ifndef DRAW_TO_SCREENS
+        BAG_Display_CreateObj(&Canvas, 16, GAME_WIDTH, GAME_HEIGHT, GAME_WIDTH, GAME_HEIGHT);
+    #endif
+    BAG_Display_CreateObj(&LevelLayer, 16, GAME_WIDTH, GAME_HEIGHT, GAME_WIDTH, GAME_HEIGHT);
     printf("play screen created!\n");
-    //load graphics
-    loadLevel("default", "level_1.tbag");
-    LoadGraphics("default");
-    printf("graphics loaded\n");
-
-    //initiate player
-    Player_Init(&Player, &Paddle, &Ball);
-    printf("player initiated\n");
 
-    //initiate aliens
-    Level_Init(&Level, &level_tiles);
-    printf("bricks initiated\n");
+    //bricks, graphics and player
+    if(!Game_Init("default", "level_1.lvl")){
+        printf("error starting the game\n");
+        ds2_plug_exit();
+    }
+#ifdef DEBUG_REWIND
+    if(!Game_EnableRewind(REWIND_BYTES))
+        printf("rewinding is off\n");
+#endif
+    printf("game initiated\n");
+
+    //first frame of the idle animation
+    playerAnimate(&Player);
     DrawScreen(&Canvas);
-
+    PROFILE_STARTUP_END();
+
+    SimClock_t clock;
+    SimClock_Start(&clock, getSysTime());
+    //presses and releases no step has seen yet, a frame that runs no step keeps them
+    Pad_t pending;
+    memset(&pending, 0, sizeof(Pad_t));
+    char screenShot = 0;
     while(1){
-        update();
-        DrawScreen(&Canvas);
-        if(Pad.Newpress.L)
+        int steps = SimClock_Steps(&clock, getSysTime());
+        Pad_t pad = Pad;
+        pending.Held = pad.Held;
+        buttonsOr(&pending.Newpress, &pad.Newpress);
+        buttonsOr(&pending.Released, &pad.Released);
+        screenShot |= pad.Newpress.L;
+        for(int i = 0; i < steps && !Game_ReplayDone(); i++){
+            Pad = pending;
+            runStep();
+            //a press only counts once however many steps the frame runs
+            memset(&pending.Newpress, 0, sizeof(PadButtons_t));
+            memset(&pending.Released, 0, sizeof(PadButtons_t));
+        }
+        Pad = pad;
+        //a chunk of the next level a frame, late frames running more steps read no more
+        updatePrefetch(LEVEL_FETCH_CHUNK);
+        //nothing moved when no step ran
+        if(steps)
+            DrawScreen(&Canvas);
+        //one shot per press as well, of a frame the press was stepped in
+        if(screenShot && steps){
             BAG_Display_ScrnCap(DUAL_SCREEN, RootDir);
+            screenShot = 0;
+        }
 
+        PROFILE_FRAME();
+        #ifdef BAG_HOST_BUILD
+            //a finished replay is the end of the run on the host
+            if(Game_ReplayDone())
+                ds2_plug_exit();
+        #endif
         BAG_Update();
     }
 }
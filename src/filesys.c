@@ -18,15 +18,6 @@ static char getSmallChar(char letter){
    return letter;
 }
 
-//count how many levels a path leads through
-static unsigned char dirLevels(char *path){
-	unsigned char count = 0;
-	char *pch = path;
-	while((pch = strchr (pch, '/')) != NULL)
-		count++;
-	return count - 1;//do not count the root /
-}
-
 
 static long dirBack(char *origPath){
 	long len = strlen(origPath) - 1;
@@ -412,8 +403,8 @@ static char *dirWalk(DirWalk *dirInfo, struct stat *st, unsigned char flags){
 			
 			dirInfo->Folder_Count++;//increase folder count
 			//copy folder name to current folder path to open
-			strcat(dirInfo->CurDir, dirInfo->filename);
-			strcat(dirInfo->CurDir,"/\0");
+			unsigned long len = strlen(dirInfo->CurDir);
+			snprintf(dirInfo->CurDir + len, sizeof(dirInfo->CurDir) - len, "%s/", dirInfo->filename);
 			
 			//close the old directory
 			closedir(dirInfo->dir);
@@ -438,7 +429,7 @@ static char *dirWalk(DirWalk *dirInfo, struct stat *st, unsigned char flags){
 }
 
 //get file information from a directory or text file
-static int _readDir(void *data, char *nameBuf, struct stat *st, char type){
+static int _readDir(void *data, char *nameBuf, unsigned long size, struct stat *st, char type){
 	char *current_file_txt = NULL;
 	dirent *current_file_dir = NULL;
 	int rtrn = 0;
@@ -463,7 +454,7 @@ static int _readDir(void *data, char *nameBuf, struct stat *st, char type){
 			}
 			else{
 				//grab a line from a text file and make ensure it's filled
-				current_file_txt = fat_getLine(nameBuf, MAX_PATH, (FILE*)data);
+				current_file_txt = fat_getLine(nameBuf, size, (FILE*)data);
 				//check if there is a file listed
 				if(current_file_txt == NULL || *current_file_txt == '\n' || 
 				   *current_file_txt == ' ' || *current_file_txt == '\r' || *current_file_txt == '\t'){
@@ -505,7 +496,7 @@ static int _dir_getEntry(void *dir, char dirType, EntryList *list, SupportedExt
 	struct stat st;
 	int tempFlags = 0, file = 0;
 
-	if((file = _readDir(dir, tempPath, &st, dirType)) > 0){
+	if((file = _readDir(dir, tempPath, sizeof(list->curDir), &st, dirType)) > 0){
 		//repeated entry when directory walking, skip it
 		if(!strncmp(tempPath, "$NOENTRY$", 9))
 			goto SKIPENTRY;
@@ -890,7 +881,7 @@ char *fsys_getEntryString(Entry *temp, FileBrowseCore *fb, unsigned char format)
 		if(GET_FLAG(entryGetFlag(temp), CUSTOMDIR))
 			strcat(fb->List->namebuf, entryGetPath(temp));
 		else//there is no specified directory
-			strcat(fb->List->namebuf, fb->List->curDir);
+			snprintf(fb->List->namebuf, sizeof(fb->List->namebuf), "%s", fb->List->curDir);
 
 		int len = strlen(fb->List->namebuf);
 		//remove trailing / unless requested.
@@ -0,0 +1,71 @@
+#ifndef _GAME_H_
+#define _GAME_H_
+
+#include <libBAG.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+State of a game in play. On the host each thread can play its own game, so
+everything a game touches is kept per thread there. The DSTwo only ever runs
+the one game and it stays a plain static.
+*/
+#ifdef BAG_HOST_BUILD
+    #define GAME_LOCAL __thread
+#else
+    #define GAME_LOCAL
+#endif
+
+typedef struct GameStats_t{
+    unsigned long steps;//fixed steps played
+    unsigned long clearedAt;//step the first level was cleared on, 0 until then
+    unsigned int bricks;//bricks broken
+    unsigned int livesLost;
+    unsigned int levels;//levels cleared
+    unsigned int score;
+    char over;//out of lives
+}GameStats_t;
+
+//what a player can see, for driving the game without a person at the pad
+typedef struct GameView_t{
+    int paddleX, paddleWd;//in pixels
+    int ballX, ballY, ballWd;
+    char ballMoving;
+    char ballReady;//back on the paddle, a launch now starts the next life
+}GameView_t;
+
+//load the skin and level, nothing is drawn so no screens are needed
+extern int Game_Init(const char *skin, const char *level);
+//start over on the level Game_Init was given, with fresh stats
+extern void Game_Restart(void);
+//one fixed step of game logic on the current Pad, without drawing
+extern void Game_Step(void);
+//let go of everything Game_Init loaded, threads call this before they finish
+extern void Game_Free(void);
+extern const GameStats_t *Game_Stats(void);
+extern void Game_View(GameView_t *view);
+
+/*
+Every step's pad can be recorded along with a hash of the game state after it
+(see replay.h). Playing the recording back feeds Pad from it instead and checks
+each step ends in the same state.
+*/
+extern unsigned int Game_Hash(void);
+extern void Game_Record(void);
+extern int Game_SaveRecording(const char *file);
+extern unsigned long Game_Recorded(void);//steps so far
+extern int Game_Replay(const char *file);
+extern char Game_ReplayDone(void);
+
+//capture every step into a ring of this many bytes, so holding Y rewinds the game
+extern int Game_EnableRewind(unsigned long bytes);
+//steps replayed so far, how many ended in another state than recorded and the first of them
+extern unsigned long Game_ReplayResult(unsigned long *mismatches, unsigned long *firstMismatch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
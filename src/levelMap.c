@@ -0,0 +1,241 @@
+#include "levelMap.h"
+#ifdef BAG_HOST_BUILD
+    #include <sys/mman.h>
+#endif
+
+//size of the old .tbag header before its u32 tiles
+#define TBAG_HEADER_SIZE 12
+
+#define READ16(p) ((p)[0] | ((p)[1] << 8))
+#define READ32(p) ((p)[0] | ((p)[1] << 8) | ((p)[2] << 16) | ((unsigned int)(p)[3] << 24))
+
+static int getShift(int value){
+    int shift = 0;
+    while((1 << shift) < value)
+        shift++;
+    return shift;
+}
+
+static void touchRow(LevelMap_t *map, int row){
+    map->touched |= 1ull << (row < 63 ? row : 63);
+}
+
+//get the whole file into memory without copying where the system allows it
+static int loadFile(LevelMap_t *map, const char *file){
+    FILE *fp = fopen(file, "rb");
+    if(!fp)
+        return 0;
+
+    fseek(fp, 0, SEEK_END);
+    map->size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if(map->size < TBAG_HEADER_SIZE){
+        fclose(fp);
+        return 0;
+    }
+
+#ifdef BAG_HOST_BUILD
+    void *data = mmap(NULL, map->size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+    if(data != MAP_FAILED){
+        map->file = data;
+        map->mapped = 1;
+        fclose(fp);
+        return 1;
+    }
+#endif
+    map->file = malloc(map->size);
+    if(map->file && fread(map->file, 1, map->size, fp) != map->size){
+        free(map->file);
+        map->file = NULL;
+    }
+    fclose(fp);
+    return map->file != NULL;
+}
+
+static void freeFile(LevelMap_t *map){
+#ifdef BAG_HOST_BUILD
+    if(map->mapped)
+        munmap(map->file, map->size);
+    else
+#endif
+    if(map->file && !map->borrowed)
+        free(map->file);
+
+    map->file = NULL;
+    map->size = 0;
+    map->mapped = map->borrowed = 0;
+}
+
+static int setSize(LevelMap_t *map, int width, int height, int tileWd, int tileHt){
+    TileGrid_t *grid = &map->grid;
+    if(width <= 0 || height <= 0 || tileWd <= 0 || tileHt <= 0)
+        return 0;
+
+    grid->width = width;
+    grid->height = height;
+    grid->tileWd = tileWd;
+    grid->tileHt = tileHt;
+    grid->divX = getShift(tileWd);
+    grid->divY = getShift(tileHt);
+    return 1;
+}
+
+//.tbag, a u32 per tile, narrowed to a byte per tile
+static int openTbag(LevelMap_t *map){
+    const unsigned char *header = map->file;
+    if(!setSize(map, READ32(&header[0]), READ32(&header[4]), READ16(&header[8]), READ16(&header[10])))
+        return 0;
+
+    unsigned long count = (unsigned long)map->grid.width * map->grid.height;
+    if(TBAG_HEADER_SIZE + count * 4 > map->size || !(map->unpacked = malloc(count)))
+        return 0;
+
+    const unsigned char *src = &map->file[TBAG_HEADER_SIZE];
+    for(unsigned long i = 0; i < count; i++, src += 4)
+        map->unpacked[i] = READ32(src) > 255 ? 0 : src[0];
+    return 1;
+}
+
+void LevelInfo_Count(LevelInfo_t *info, const unsigned char *tiles, int width, int height){
+    memset(info, 0, sizeof(LevelInfo_t));
+    info->firstRow = height;
+    info->lastRow = -1;
+
+    for(int row = 0; row < height; row++){
+        for(int col = 0; col < width; col++){
+            int tile = tiles[row * width + col];
+            info->histogram[tile]++;
+            if(tile >= info->types)
+                info->types = tile + 1;
+            if(!tile)
+                continue;
+
+            info->bricks++;
+            if(row < info->firstRow)
+                info->firstRow = row;
+            info->lastRow = row;
+        }
+    }
+}
+
+//metadata block of a .lvl, 0 when it does not fit in the file
+static int readInfo(LevelMap_t *map, unsigned long offset){
+    LevelInfo_t *info = &map->info;
+    const unsigned char *data = &map->file[offset];
+    if(offset + 8 > map->size)
+        return 0;
+
+    info->bricks = READ16(&data[0]);
+    info->firstRow = READ16(&data[2]);
+    info->lastRow = (short)READ16(&data[4]);
+    info->types = READ16(&data[6]);
+    if(info->types > LEVEL_MAX_TYPES || offset + 8 + info->types * 2 > map->size)
+        return 0;
+    for(int i = 0; i < info->types; i++)
+        info->histogram[i] = READ16(&data[8 + i * 2]);
+    return 1;
+}
+
+static int openLvl(LevelMap_t *map){
+    const unsigned char *header = map->file;
+    if(header[4] != LEVEL_VERSION || !setSize(map, READ16(&header[8]), READ16(&header[10]), header[6], header[7]))
+        return 0;
+
+    int width = map->grid.width, height = map->grid.height;
+    unsigned long offset = READ16(&header[12]),
+                  count = (unsigned long)width * height;
+    if(GET_FLAG(header[5], LEVEL_HAS_INFO) && !readInfo(map, LEVEL_HEADER_SIZE))
+        return 0;
+
+    //stored as is, play straight from the file
+    if(!GET_FLAG(header[5], LEVEL_PACKED_ROWS)){
+        if(offset + count > map->size)
+            return 0;
+        map->tiles = &map->file[offset];
+        return 1;
+    }
+
+    if(!(map->unpacked = calloc(count, 1)))
+        return 0;
+    for(int row = 0; row < height;){
+        if(offset + 2 > map->size)
+            return 0;
+        int empty = map->file[offset], stored = map->file[offset + 1];
+        offset += 2;
+        row += empty;
+
+        if(stored > height - row || offset + stored * width > map->size)
+            return 0;
+        memcpy(&map->unpacked[row * width], &map->file[offset], stored * width);
+        offset += stored * width;
+        row += stored;
+
+        if(!empty && !stored)
+            return 0;
+    }
+    return 1;
+}
+
+//make the grid in play from whatever file data map holds
+static int openData(LevelMap_t *map){
+    int ok = map->size >= TBAG_HEADER_SIZE &&
+             ((map->size >= LEVEL_HEADER_SIZE && !memcmp(map->file, LEVEL_MAGIC, 4)) ? openLvl(map) : openTbag(map));
+    if(!ok){
+        LevelMap_Close(map);
+        return 0;
+    }
+    //levels from before the compiler counted them
+    if(!map->info.types)
+        LevelInfo_Count(&map->info, map->unpacked ? map->unpacked : map->tiles, map->grid.width, map->grid.height);
+
+    //the file is only kept around when the grid is read straight out of it
+    if(map->unpacked){
+        map->tiles = map->unpacked;
+        freeFile(map);
+    }
+
+    unsigned long count = (unsigned long)map->grid.width * map->grid.height;
+    if(!(map->grid.tiles = malloc(count))){
+        LevelMap_Close(map);
+        return 0;
+    }
+    memcpy(map->grid.tiles, map->tiles, count);
+    return 1;
+}
+
+int LevelMap_Open(LevelMap_t *map, const char *file){
+    memset(map, 0, sizeof(LevelMap_t));
+    if(!loadFile(map, file))
+        return 0;
+    return openData(map);
+}
+
+int LevelMap_OpenMem(LevelMap_t *map, const unsigned char *data, unsigned long size, int owned){
+    memset(map, 0, sizeof(LevelMap_t));
+    map->file = (unsigned char *)data;
+    map->size = size;
+    map->borrowed = !owned;
+    return openData(map);
+}
+
+void LevelMap_Close(LevelMap_t *map){
+    freeFile(map);
+    if(map->unpacked)
+        free(map->unpacked);
+    if(map->grid.tiles)
+        free(map->grid.tiles);
+    memset(map, 0, sizeof(LevelMap_t));
+}
+
+void LevelMap_Touch(LevelMap_t *map, const unsigned char *tile){
+    touchRow(map, (tile - map->grid.tiles) / map->grid.width);
+}
+
+void LevelMap_Reset(LevelMap_t *map){
+    int width = map->grid.width;
+    for(int row = 0; map->touched && row < map->grid.height; row++){
+        if(map->touched & (1ull << (row < 63 ? row : 63)))
+            memcpy(&map->grid.tiles[row * width], &map->tiles[row * width], width);
+    }
+    map->touched = 0;
+}
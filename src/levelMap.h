@@ -0,0 +1,70 @@
+#ifndef _LEVELMAP_H_
+#define _LEVELMAP_H_
+
+#include <libBAG.h>
+#include "quick2dEngine.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+.lvl level files, little endian, a byte per tile:
+    "LVL8", u8 version, u8 flags, u8 tileWd, u8 tileHt,
+    u16 width, u16 height, u16 offset of the tiles, u16 reserved
+then width * height tiles. With LEVEL_PACKED_ROWS set the tiles are stored as
+runs of u8 empty rows, u8 stored rows and the stored rows tiles, until every
+row is covered. LEVEL_HAS_INFO puts a LevelInfo_t worked out when the level
+was compiled straight after the header:
+    u16 bricks, u16 first row, u16 last row, u16 tile ids, u16 count per id
+Older .tbag files (u32 per tile) load as well.
+*/
+#define LEVEL_MAGIC "LVL8"
+#define LEVEL_VERSION 1
+#define LEVEL_HEADER_SIZE 16
+#define LEVEL_PACKED_ROWS (1<<0)
+#define LEVEL_HAS_INFO (1<<1)
+#define LEVEL_MAX_TYPES 256
+
+typedef struct LevelInfo_t{
+    int bricks;//tiles that are not empty
+    int firstRow, lastRow;//rows with bricks in them, first is past last when there are none
+    int types;//tile ids counted in histogram
+    unsigned short histogram[LEVEL_MAX_TYPES];//how many of each tile id the level has
+}LevelInfo_t;
+
+//fill in info for a grid of tiles
+extern void LevelInfo_Count(LevelInfo_t *info, const unsigned char *tiles, int width, int height);
+
+/*
+A level file is opened once and kept as it is on disk, mapped on the host and
+read whole into memory on the DS. The grid the game breaks bricks in is a
+separate copy, and only the rows that were hit are copied back from the file
+when the level restarts.
+*/
+typedef struct LevelMap_t{
+    unsigned char *file;//the whole level file
+    unsigned long size;
+    char mapped, borrowed;//borrowed data belongs to someone else, eg. a level pack
+
+    const unsigned char *tiles;//grid as loaded, points into file when it is stored unpacked
+    unsigned char *unpacked;//otherwise it is unpacked here and the file is let go
+    TileGrid_t grid;//grid in play
+    LevelInfo_t info;//of the level as loaded
+    unsigned long long touched;//bit per row of grid that may differ from tiles, the last bit covers any rows past it
+}LevelMap_t;
+
+extern int LevelMap_Open(LevelMap_t *map, const char *file);
+//level file already in memory, owned data is freed with the map
+extern int LevelMap_OpenMem(LevelMap_t *map, const unsigned char *data, unsigned long size, int owned);
+extern void LevelMap_Close(LevelMap_t *map);
+//a tile of the grid in play is about to change
+extern void LevelMap_Touch(LevelMap_t *map, const unsigned char *tile);
+//put every touched row back the way it was loaded
+extern void LevelMap_Reset(LevelMap_t *map);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
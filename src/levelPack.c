@@ -0,0 +1,167 @@
+#include "levelPack.h"
+#ifdef BAG_HOST_BUILD
+    #include <sys/mman.h>
+#endif
+
+#define READ16(p) ((p)[0] | ((p)[1] << 8))
+#define READ32(p) ((p)[0] | ((p)[1] << 8) | ((p)[2] << 16) | ((unsigned int)(p)[3] << 24))
+
+unsigned int LevelPack_Checksum(const unsigned char *data, unsigned long length){
+    unsigned int hash = 2166136261u;
+    for(unsigned long i = 0; i < length; i++){
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+int LevelPack_Open(LevelPack_t *pack, const char *file){
+    unsigned char buf[LEVELPACK_ENTRY_SIZE];
+    memset(pack, 0, sizeof(LevelPack_t));
+    if(!(pack->file = fopen(file, "rb")))
+        return 0;
+
+    fseek(pack->file, 0, SEEK_END);
+    pack->size = ftell(pack->file);
+    fseek(pack->file, 0, SEEK_SET);
+
+    if(fread(buf, LEVELPACK_HEADER_SIZE, 1, pack->file) != 1 || memcmp(buf, LEVELPACK_MAGIC, 4) ||
+       READ16(&buf[4]) != LEVELPACK_VERSION)
+        goto FAIL;
+    pack->count = READ16(&buf[6]);
+    if(pack->count > LEVELPACK_MAX_LEVELS)
+        goto FAIL;
+
+    for(int i = 0; i < pack->count; i++){
+        LevelPackEntry_t *entry = &pack->index[i];
+        if(fread(buf, LEVELPACK_ENTRY_SIZE, 1, pack->file) != 1)
+            goto FAIL;
+        memcpy(entry->name, buf, LEVELPACK_NAME_LEN);
+        entry->name[LEVELPACK_NAME_LEN - 1] = '\0';
+        entry->offset = READ32(&buf[LEVELPACK_NAME_LEN]);
+        entry->length = READ32(&buf[LEVELPACK_NAME_LEN + 4]);
+        entry->checksum = READ32(&buf[LEVELPACK_NAME_LEN + 8]);
+        if((unsigned long)entry->offset + entry->length > pack->size)
+            goto FAIL;
+    }
+
+#ifdef BAG_HOST_BUILD
+    void *data = mmap(NULL, pack->size, PROT_READ, MAP_PRIVATE, fileno(pack->file), 0);
+    if(data != MAP_FAILED)
+        pack->data = data;
+#endif
+    return 1;
+
+    FAIL:
+        LevelPack_Close(pack);
+        return 0;
+}
+
+void LevelPack_Close(LevelPack_t *pack){
+#ifdef BAG_HOST_BUILD
+    if(pack->data)
+        munmap((void *)pack->data, pack->size);
+#endif
+    if(pack->file)
+        fclose(pack->file);
+    memset(pack, 0, sizeof(LevelPack_t));
+}
+
+int LevelPack_Find(LevelPack_t *pack, const char *name){
+    for(int i = 0; i < pack->count; i++){
+        if(!strcmp(pack->index[i].name, name))
+            return i;
+    }
+    return -1;
+}
+
+const unsigned char *LevelPack_Read(LevelPack_t *pack, int level, unsigned long *length, int *owned){
+    if(level < 0 || level >= pack->count)
+        return NULL;
+
+    LevelPackEntry_t *entry = &pack->index[level];
+    const unsigned char *data = NULL;
+    *owned = 0;
+    if(pack->data)
+        data = &pack->data[entry->offset];
+    else{
+        //one seek and one read
+        unsigned char *buf = malloc(entry->length);
+        if(!buf)
+            return NULL;
+        if(fseek(pack->file, entry->offset, SEEK_SET) || fread(buf, 1, entry->length, pack->file) != entry->length){
+            free(buf);
+            return NULL;
+        }
+        data = buf;
+        *owned = 1;
+    }
+
+    if(LevelPack_Checksum(data, entry->length) != entry->checksum){
+        printf("level %s is damaged\n", entry->name);
+        if(*owned)
+            free((void *)data);
+        return NULL;
+    }
+    *length = entry->length;
+    return data;
+}
+
+void LevelPack_FetchStart(LevelPack_t *pack, LevelFetch_t *fetch, int level){
+    memset(fetch, 0, sizeof(LevelFetch_t));
+    fetch->level = -1;
+    if(level < 0 || level >= pack->count)
+        return;
+
+    fetch->level = level;
+    fetch->length = pack->index[level].length;
+    //already in memory, there is nothing to read
+    if(pack->data){
+        fetch->data = &pack->data[pack->index[level].offset];
+        fetch->done = fetch->length;
+    }
+}
+
+int LevelPack_FetchStep(LevelPack_t *pack, LevelFetch_t *fetch, unsigned long chunk){
+    if(fetch->level < 0)
+        return -1;
+
+    LevelPackEntry_t *entry = &pack->index[fetch->level];
+    if(!pack->data && fetch->done < fetch->length){
+        if(!fetch->buf && !(fetch->buf = malloc(fetch->length)))
+            goto FAIL;
+
+        //seek every time, other reads may have moved the file along
+        unsigned long size = fetch->length - fetch->done;
+        if(size > chunk)
+            size = chunk;
+        if(fseek(pack->file, entry->offset + fetch->done, SEEK_SET) ||
+           fread(&fetch->buf[fetch->done], 1, size, pack->file) != size)
+            goto FAIL;
+        fetch->done += size;
+        if(fetch->done < fetch->length)
+            return 0;
+
+        fetch->data = fetch->buf;
+        fetch->owned = 1;
+    }
+    if(!fetch->checked){
+        if(LevelPack_Checksum(fetch->data, fetch->length) != entry->checksum){
+            printf("level %s is damaged\n", entry->name);
+            goto FAIL;
+        }
+        fetch->checked = 1;
+    }
+    return 1;
+
+    FAIL:
+        LevelPack_FetchCancel(fetch);
+        return -1;
+}
+
+void LevelPack_FetchCancel(LevelFetch_t *fetch){
+    if(fetch->buf)
+        free(fetch->buf);
+    memset(fetch, 0, sizeof(LevelFetch_t));
+    fetch->level = -1;
+}
@@ -0,0 +1,69 @@
+#ifndef _LEVELPACK_H_
+#define _LEVELPACK_H_
+
+#include <libBAG.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+Every level in one file so switching levels never searches a directory.
+Little endian:
+    "LPAK", u16 version, u16 count
+    count entries of char name[32], u32 offset, u32 length, u32 checksum
+followed by the level files themselves. The checksum is FNV-1a over a
+level's bytes.
+*/
+#define LEVELPACK_MAGIC "LPAK"
+#define LEVELPACK_VERSION 1
+#define LEVELPACK_HEADER_SIZE 8
+#define LEVELPACK_NAME_LEN 32
+#define LEVELPACK_ENTRY_SIZE (LEVELPACK_NAME_LEN + 12)
+#define LEVELPACK_MAX_LEVELS 256
+
+typedef struct LevelPackEntry_t{
+    char name[LEVELPACK_NAME_LEN];
+    unsigned int offset, length, checksum;
+}LevelPackEntry_t;
+
+typedef struct LevelPack_t{
+    FILE *file;
+    const unsigned char *data;//whole pack when it could be mapped
+    unsigned long size;
+    int count;
+    LevelPackEntry_t index[LEVELPACK_MAX_LEVELS];
+}LevelPack_t;
+
+extern unsigned int LevelPack_Checksum(const unsigned char *data, unsigned long length);
+//reads the index, the pack stays open until closed
+extern int LevelPack_Open(LevelPack_t *pack, const char *file);
+extern void LevelPack_Close(LevelPack_t *pack);
+//index of a level by file name, -1 when the pack does not have it
+extern int LevelPack_Find(LevelPack_t *pack, const char *name);
+/*
+One level's bytes, checked against the index. When owned comes back set the
+data was read for the caller and has to be freed, otherwise it points into the
+mapped pack. NULL on a bad read or checksum.
+*/
+extern const unsigned char *LevelPack_Read(LevelPack_t *pack, int level, unsigned long *length, int *owned);
+
+//a level read a chunk at a time, so loading can be spread over frames of play
+typedef struct LevelFetch_t{
+    int level;//-1 when nothing is being read
+    unsigned char *buf;
+    const unsigned char *data;//set once the level is all in and checked
+    unsigned long done, length;
+    char owned, checked;
+}LevelFetch_t;
+
+extern void LevelPack_FetchStart(LevelPack_t *pack, LevelFetch_t *fetch, int level);
+//read up to chunk more bytes, 1 once the level is in, -1 if it could not be read
+extern int LevelPack_FetchStep(LevelPack_t *pack, LevelFetch_t *fetch, unsigned long chunk);
+extern void LevelPack_FetchCancel(LevelFetch_t *fetch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,122 @@
+#include "profile.h"
+#include "game.h"
+
+#ifdef FRAME_PROFILE
+#include <time.h>
+
+static const char *phaseNames[PROFILE_TOTAL_PHASES] = {
+    "player update",
+    "BallBrickCollision",
+    "ball pool",
+    "background blit",
+    "levelDraw",
+    "playerDraw",
+    "Flip_Screen",
+    "snapshot",
+};
+
+typedef struct Profile_t{
+    //per frame samples, one row per phase plus the whole frame
+    unsigned long long *samples[PROFILE_TOTAL_PHASES + 1];
+    unsigned long long cur[PROFILE_TOTAL_PHASES],
+                       start[PROFILE_TOTAL_PHASES],
+                       frameStart,
+                       startupStart, startup;
+    int stack[PROFILE_TOTAL_PHASES], depth;
+    unsigned long frame, maxFrames;
+}Profile_t;
+
+static GAME_LOCAL Profile_t Profile = {{0}};
+
+static unsigned long long profileNow(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+int Profile_Init(unsigned long frames){
+    memset(&Profile, 0, sizeof(Profile_t));
+    for(int i = 0; i <= PROFILE_TOTAL_PHASES; i++){
+        Profile.samples[i] = calloc(frames, sizeof(unsigned long long));
+        if(Profile.samples[i] == NULL)
+            return 0;
+    }
+    Profile.maxFrames = frames;
+    Profile.frameStart = profileNow();
+    return 1;
+}
+
+void Profile_Begin(int phase){
+    if(!Profile.maxFrames)
+        return;
+    Profile.start[phase] = profileNow();
+    Profile.stack[Profile.depth++] = phase;
+}
+
+void Profile_End(int phase){
+    if(!Profile.maxFrames)
+        return;
+    unsigned long long elapsed = profileNow() - Profile.start[phase];
+    Profile.cur[phase] += elapsed;
+    //take the time out of the enclosing phase
+    if(--Profile.depth > 0)
+        Profile.cur[Profile.stack[Profile.depth - 1]] -= elapsed;
+}
+
+void Profile_EndFrame(void){
+    if(!Profile.maxFrames || Profile.frame >= Profile.maxFrames)
+        return;
+
+    unsigned long long now = profileNow();
+    for(int i = 0; i < PROFILE_TOTAL_PHASES; i++)
+        Profile.samples[i][Profile.frame] = Profile.cur[i];
+    Profile.samples[PROFILE_TOTAL_PHASES][Profile.frame] = now - Profile.frameStart;
+
+    memset(Profile.cur, 0, sizeof(Profile.cur));
+    Profile.frameStart = now;
+    Profile.frame++;
+}
+
+void Profile_StartupBegin(void){
+    if(!Profile.maxFrames)
+        return;
+    Profile.startupStart = profileNow();
+}
+
+void Profile_StartupEnd(void){
+    if(!Profile.maxFrames)
+        return;
+    //the first frame starts now, not when the profile was set up
+    Profile.frameStart = profileNow();
+    Profile.startup = Profile.frameStart - Profile.startupStart;
+}
+
+static int sampleCompare(const void *a, const void *b){
+    unsigned long long x = *(const unsigned long long*)a, y = *(const unsigned long long*)b;
+    return (x > y) - (x < y);
+}
+
+void Profile_Report(void){
+    unsigned long frames = Profile.frame;
+    if(!frames)
+        return;
+
+    if(Profile.startup)
+        printf("\nstartup: %llu us\n", Profile.startup / 1000);
+    printf("\n%lu frames, ns/frame\n", frames);
+    printf("%-20s %10s %10s %10s %10s\n", "phase", "min", "median", "p99", "mean");
+    for(int i = 0; i <= PROFILE_TOTAL_PHASES; i++){
+        unsigned long long *s = Profile.samples[i], sum = 0;
+        qsort(s, frames, sizeof(unsigned long long), &sampleCompare);
+        for(unsigned long j = 0; j < frames; j++)
+            sum += s[j];
+
+        printf("%-20s %10llu %10llu %10llu %10llu\n", i < PROFILE_TOTAL_PHASES ? phaseNames[i] : "frame",
+               s[0], s[frames >> 1], s[(frames * 99) / 100], sum / frames);
+    }
+    unsigned long long median = Profile.samples[PROFILE_TOTAL_PHASES][frames >> 1];
+    if(median)
+        printf("median frame rate: %llu fps\n", 1000000000ULL / median);
+}
+
+#endif
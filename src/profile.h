@@ -0,0 +1,54 @@
+#ifndef _PROFILE_H_
+#define _PROFILE_H_
+
+#include <libBAG.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+Per frame phase timing, only compiled in when FRAME_PROFILE is defined.
+Phases may nest, a phase only counts time not spent in the phases inside it.
+*/
+typedef enum{
+    PROFILE_PLAYER_UPDATE,
+    PROFILE_COLLISION,
+    PROFILE_BALL_POOL,
+    PROFILE_BACKGROUND,
+    PROFILE_LEVEL_DRAW,
+    PROFILE_PLAYER_DRAW,
+    PROFILE_FLIP,
+    PROFILE_SNAPSHOT,
+    PROFILE_TOTAL_PHASES,
+}PROFILE_PHASES;
+
+#ifdef FRAME_PROFILE
+    #define PROFILE_BEGIN(phase) Profile_Begin(phase)
+    #define PROFILE_END(phase) Profile_End(phase)
+    #define PROFILE_FRAME() Profile_EndFrame()
+    #define PROFILE_STARTUP_BEGIN() Profile_StartupBegin()
+    #define PROFILE_STARTUP_END() Profile_StartupEnd()
+#else
+    #define PROFILE_BEGIN(phase)
+    #define PROFILE_END(phase)
+    #define PROFILE_FRAME()
+    #define PROFILE_STARTUP_BEGIN()
+    #define PROFILE_STARTUP_END()
+#endif
+
+extern int Profile_Init(unsigned long frames);
+extern void Profile_Begin(int phase);
+extern void Profile_End(int phase);
+extern void Profile_EndFrame(void);
+//time from start up to the first frame, reported on its own
+extern void Profile_StartupBegin(void);
+extern void Profile_StartupEnd(void);
+extern void Profile_Report(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif
@@ -2,66 +2,44 @@
 
 //flip horizontal component from left to right or right to left
 short angle_horFlip(short angle){
-    if(angle == ANGLE_LEFT)
-        return ANGLE_RIGHT;
-    else if(angle == ANGLE_RIGHT)
-        return ANGLE_LEFT;
-    else if(angle == ANGLE_UP_RIGHT)
-        return ANGLE_UP_LEFT;
-    else if(angle == ANGLE_UP_LEFT)
-        return ANGLE_UP_RIGHT;
-    else if(angle == ANGLE_DOWN_RIGHT)
-        return ANGLE_DOWN_LEFT;
-    else if(angle == ANGLE_DOWN_LEFT)
-        return ANGLE_DOWN_RIGHT;
-    return angle;
+    return FLIP_HOR(angle);
 }
 
 short angle_vertFlip(short angle){
-    if(angle == ANGLE_UP)
-        return ANGLE_DOWN;
-    else if(angle == ANGLE_UP_LEFT)
-        return ANGLE_DOWN_LEFT;
-    else if(angle == ANGLE_DOWN_LEFT)
-        return ANGLE_UP_LEFT;
-    else if(angle == ANGLE_UP_RIGHT)
-        return ANGLE_DOWN_RIGHT;
-    else if(angle == ANGLE_DOWN_RIGHT)
-        return ANGLE_UP_RIGHT;
-    else if(angle == ANGLE_DOWN)
-        return ANGLE_UP;
-
-    return angle;
+    return FLIP_VERT(angle);
 }
 
-/*
-Positioning stuff and movement
-*/
-static int *getPointX(Point_t *pt){
-    return &pt->x;
-}
-
-static int *getPointY(Point_t *pt){
-    return &pt->y;
-}
+//angle heading up and turned towards the side of whatever was hit, offset is
+//how far from the centre the hit was out of range, 0 uses the side of dir
+short angle_steer(int offset, int range, int dir, int minSteer, int maxSteer){
+    int steer = range > 0 ? (offset * maxSteer) / range : 0;
+    if(steer > maxSteer)
+        steer = maxSteer;
+    else if(steer < -maxSteer)
+        steer = -maxSteer;
 
-static int *getPointSpeed(Point_t *pt){
-    return &pt->speed;
+    //never send it straight up
+    if(abs(steer) < minSteer)
+        steer = (offset > 0 || (offset == 0 && dir >= 0)) ? minSteer : -minSteer;
+    return (ANGLE_UP + steer)&511;
 }
 
-static int *getPointAngle(Point_t *pt){
-    return &pt->angle;
-}
-
-static void updatePoint(Point_t *pt){
-    //speed is based on fixed point maths
-    (*getPointY(pt)) += ( BAG_Sin(*getPointAngle(pt)) * fix_norm(*getPointSpeed(pt)) );
-    (*getPointX(pt)) += ( BAG_Cos(*getPointAngle(pt)) * fix_norm(*getPointSpeed(pt)) );
+/*
+Positioning stuff and movement
+*/
+//bounce off a vertical surface, the sin table is symmetric so negating the
+//step gives the same result as recomputing it for the mirrored angle
+void point_flipHor(Point_t *pt){
+    point_velocity(pt);
+    pt->vx = -pt->vx;
+    pt->vAngle = pt->angle = FLIP_HOR(pt->angle);
 }
 
-static char onscreenPoint(Point_t *pt){
-    return (fix_norm(*pt->getX(pt)) >= 0 && fix_norm(*pt->getX(pt)) <= GAME_WIDTH &&
-            fix_norm(*pt->getY(pt)) >= 0 && fix_norm(*pt->getY(pt)) <= GAME_HEIGHT);
+//bounce off a horizontal surface
+void point_flipVert(Point_t *pt){
+    point_velocity(pt);
+    pt->vy = -pt->vy;
+    pt->vAngle = pt->angle = FLIP_VERT(pt->angle);
 }
 
 void initPoint(Point_t *pt){
@@ -70,15 +48,13 @@ void initPoint(Point_t *pt){
     pt->y = -32;
     pt->speed = 0;
     pt->angle = 0;
-
-    pt->getX = (void*)&getPointX;
-    pt->getY = (void*)&getPointY;
-    pt->getSpeed = (void*)&getPointSpeed;
-    pt->getAngle = (void*)&getPointAngle;
-    pt->onScreen = (void*)&onscreenPoint;
-    pt->update = (void*)&updatePoint;
+    pt->vAngle = -1;//force the step to be worked out on first update
 }
 
+const PointMethods_t Point_Methods = {
+    &point_getX, &point_getY, &point_getSpeed, &point_getAngle, &point_onScreen, &point_update,
+};
+
 
 
 /*==========================================================================
@@ -101,8 +77,8 @@ int obj_collision(GFXObj_t *spr1, GFXObj_t *spr2){
 int obj_collision_PtObj(Point_t *p1, GFXObj_t *spr1, GFXObj_t *spr2){
     register int w1 = *BAG_Display_GetGfxFrameWd(spr1),
                  h1 = *BAG_Display_GetGfxFrameHt(spr1),
-                 x1 = fix_norm(*p1->getX(p1)) + (w1 >> 1),
-                 y1 = fix_norm(*p1->getY(p1)) + (h1 >> 1),
+                 x1 = fix_norm(*point_getX(p1)) + (w1 >> 1),
+                 y1 = fix_norm(*point_getY(p1)) + (h1 >> 1),
                  w2 = *BAG_Display_GetGfxFrameWd(spr2),
                  h2 = *BAG_Display_GetGfxFrameHt(spr2),
                  x2 = *BAG_Display_GetGfxBlitX(spr2) + (w2 >> 1),
@@ -114,12 +90,12 @@ int obj_collision_PtObj(Point_t *p1, GFXObj_t *spr1, GFXObj_t *spr2){
 int obj_collision_PtPt(Point_t *p1, GFXObj_t *spr1, Point_t *p2, GFXObj_t *spr2){
     register int w1 = *BAG_Display_GetGfxFrameWd(spr1),
                  h1 = *BAG_Display_GetGfxFrameHt(spr1),
-                 x1 = fix_norm(*p1->getX(p1)) + (w1 >> 1),
-                 y1 = fix_norm(*p1->getY(p1)) + (h1 >> 1),
+                 x1 = fix_norm(*point_getX(p1)) + (w1 >> 1),
+                 y1 = fix_norm(*point_getY(p1)) + (h1 >> 1),
                  w2 = *BAG_Display_GetGfxFrameWd(spr2),
                  h2 = *BAG_Display_GetGfxFrameHt(spr2),
-                 x2 = fix_norm(*p2->getX(p2)) + (w2 >> 1),
-                 y2 = fix_norm(*p2->getY(p2)) + (h2 >> 1);
+                 x2 = fix_norm(*point_getX(p2)) + (w2 >> 1),
+                 y2 = fix_norm(*point_getY(p2)) + (h2 >> 1);
     //rectangular collision logic
     return((x2 >= x1 - ((w1 + w2)>>1)) && (x2 <= x1 + ((w1 + w2)>>1)) && (y2 >= y1 - ((h1 + h2)>>1)) && (y2 <= y1 + ((h1 + h2)>>1)));  
 }
@@ -135,8 +111,8 @@ int obj_collisionArea(GFXObj_t *gfx, int x1, int y1, int x2, int y2){
 }
 //check if an object is in an area based on its point on screen
 int obj_collisionArea_Pt(Point_t *pt, GFXObj_t *gfx, int x1, int y1, int x2, int y2){
-    int x = fix_norm(*pt->getX(pt)),
-        y = fix_norm(*pt->getY(pt)),
+    int x = fix_norm(*point_getX(pt)),
+        y = fix_norm(*point_getY(pt)),
         wd = *BAG_Display_GetGfxFrameWd(gfx),
         ht = *BAG_Display_GetGfxFrameHt(gfx);
 
@@ -187,8 +163,8 @@ static int getTileCol(TiledBG_t *bg, int scrollX, int scrollY, int x, int y, int
 int obj_collisionTile(GFXObj_t *gfx, Point_t *bgPos, TiledBG_t *bg, unsigned int *matrix[4][3]){
     int conditions = 0;//collision conditions
 
-    int x = fix_norm(*bgPos->getX(bgPos));
-    int y = fix_norm(*bgPos->getY(bgPos));
+    int x = fix_norm(*point_getX(bgPos));
+    int y = fix_norm(*point_getY(bgPos));
 
     //check if bullet is in alien area
     if(obj_collisionArea(gfx, x, y, x + (bg->width * bg->tileWd), y + (bg->height * bg->tileHt))){
@@ -202,16 +178,166 @@ int obj_collisionTile(GFXObj_t *gfx, Point_t *bgPos, TiledBG_t *bg, unsigned int
     return conditions;   
 }
 
+/*=====================================
+Swept Tile Collision
+=======================================*/
+int grid_getTile(TileGrid_t *grid, int x, int y){
+    if(x < 0 || y < 0 || x >= grid->width || y >= grid->height)
+        return 0;
+    return grid->tiles[y * grid->width + x];
+}
+
+unsigned char *grid_getTileAddr(TileGrid_t *grid, int x, int y){
+    if(x < 0 || y < 0 || x >= grid->width || y >= grid->height)
+        return NULL;
+    return &grid->tiles[y * grid->width + x];
+}
+
+//find the first solid tile in a column (or row) of cells, from first to last
+static int sweepFindTile(TileGrid_t *bg, int fixed, int first, int last, int isColumn, TileHit_t *hit){
+    for(int i = first; i <= last; i++){
+        int tx = isColumn ? fixed : i,
+            ty = isColumn ? i : fixed;
+        if(grid_getTile(bg, tx, ty) > 0){
+            hit->tileX = tx;
+            hit->tileY = ty;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+//check whether any map row a box passes through while moving by dy is marked in rows,
+//lets the sweep be skipped when the box only moves through empty rows
+int obj_sweepRowsOccupied(int y, int ht, int dy, Point_t *bgPos, TileGrid_t *bg, const unsigned int *rows){
+    int shiftY = bg->divY + 8,
+        bgY = *point_getY(bgPos) & ~0xff;
+    int row1 = (((dy < 0) ? y + dy : y) - bgY) >> shiftY,
+        row2 = (((dy > 0) ? y + dy : y) - bgY + norm_fix(ht) - 1) >> shiftY;
+
+    if(row1 < 0)
+        row1 = 0;
+    if(row2 >= bg->height)
+        row2 = bg->height - 1;
+    for(; row1 <= row2; row1++){
+        if(rows[row1])
+            return 1;
+    }
+    return 0;
+}
+
+/*
+Walk a wd x ht box from x,y (fixed point) along dx,dy through the tile grid
+one cell boundary at a time, stopping at the first solid tile its leading
+edges run into. Returns the COLLISION_ side of the box that hit, 0 for none.
+Because every boundary crossed is checked, fast boxes can not skip tiles.
+*/
+int obj_sweepTile(int x, int y, int wd, int ht, int dx, int dy, Point_t *bgPos, TileGrid_t *bg, TileHit_t *hit){
+    int shiftX = bg->divX + 8, shiftY = bg->divY + 8,
+        cellWd = 1 << shiftX, cellHt = 1 << shiftY;
+    //work relative to the backgrounds origin, on whole pixels like drawing does
+    int bgX = *point_getX(bgPos) & ~0xff,
+        bgY = *point_getY(bgPos) & ~0xff;
+    int cx = x - bgX, cy = y - bgY,
+        w = norm_fix(wd), h = norm_fix(ht),
+        rx = abs(dx), ry = abs(dy),
+        sx = (dx > 0) - (dx < 0), sy = (dy > 0) - (dy < 0);
+
+    memset(hit, 0, sizeof(TileHit_t));
+
+    //already inside a tile, push back against the vertical motion
+    if(sweepFindTile(bg, cx >> shiftX, cy >> shiftY, (cy + h - 1) >> shiftY, 1, hit) ||
+       sweepFindTile(bg, (cx + w - 1) >> shiftX, cy >> shiftY, (cy + h - 1) >> shiftY, 1, hit)){
+        hit->x = x;
+        hit->y = y;
+        goto FOUND_VERT;
+    }
+
+    while(rx > 0 || ry > 0){
+        //distance from the leading edges to the next cell boundaries
+        int lx = (sx > 0) ? cx + w - 1 : cx,
+            ly = (sy > 0) ? cy + h - 1 : cy;
+        int distX = (sx > 0) ? ((lx >> shiftX) + 1) * cellWd - lx : (sx < 0) ? lx - (lx >> shiftX) * cellWd + 1 : 0,
+            distY = (sy > 0) ? ((ly >> shiftY) + 1) * cellHt - ly : (sy < 0) ? ly - (ly >> shiftY) * cellHt + 1 : 0;
+        int crossX = (sx != 0 && distX <= rx),
+            crossY = (sy != 0 && distY <= ry);
+
+        if(!crossX && !crossY)
+            break;
+
+        //pick whichever boundary is reached first along the motion
+        long long tX = (long long)distX * ry, tY = (long long)distY * rx;
+        if(crossX && crossY){
+            if(tX < tY)
+                crossY = 0;
+            else if(tY < tX)
+                crossX = 0;
+        }
+
+        int stepX, stepY;
+        if(crossX){
+            stepX = distX;
+            stepY = crossY ? distY : (int)(((long long)distX * ry) / rx);
+        }
+        else{
+            stepY = distY;
+            stepX = (int)(((long long)distY * rx) / ry);
+        }
+
+        //position just before entering the new cells
+        int nx = cx + sx * (stepX - (crossX ? 1 : 0)),
+            ny = cy + sy * (stepY - (crossY ? 1 : 0));
+        int col1 = nx >> shiftX, col2 = (nx + w - 1) >> shiftX,
+            row1 = ny >> shiftY, row2 = (ny + h - 1) >> shiftY;
+        int newCol = ((sx > 0) ? nx + w : nx - 1) >> shiftX,
+            newRow = ((sy > 0) ? ny + h : ny - 1) >> shiftY;
+
+        hit->x = nx + bgX;
+        hit->y = ny + bgY;
+        if(crossX && sweepFindTile(bg, newCol, row1, row2, 1, hit)){
+            if(crossY && sweepFindTile(bg, newRow, col1, col2, 0, hit))
+                goto FOUND_BOTH;
+            goto FOUND_HOR;
+        }
+        if(crossY && sweepFindTile(bg, newRow, col1, col2, 0, hit))
+            goto FOUND_VERT;
+        //exactly through a corner
+        if(crossX && crossY && grid_getTile(bg, newCol, newRow) > 0){
+            hit->tileX = newCol;
+            hit->tileY = newRow;
+            goto FOUND_BOTH;
+        }
+
+        cx += sx * stepX;
+        cy += sy * stepY;
+        rx -= stepX;
+        ry -= stepY;
+    }
+    hit->x = x + dx;
+    hit->y = y + dy;
+    return 0;
+
+    FOUND_HOR:
+        hit->tile = grid_getTileAddr(bg, hit->tileX, hit->tileY);
+        return (sx > 0) ? COLLISION_RIGHT : COLLISION_LEFT;
+    FOUND_VERT:
+        hit->tile = grid_getTileAddr(bg, hit->tileX, hit->tileY);
+        return (sy > 0) ? COLLISION_DOWN : COLLISION_UP;
+    FOUND_BOTH:
+        hit->tile = grid_getTileAddr(bg, hit->tileX, hit->tileY);
+        return ((sx > 0) ? COLLISION_RIGHT : COLLISION_LEFT) | ((sy > 0) ? COLLISION_DOWN : COLLISION_UP);
+}
+
 int obj_collisionTile_Pt(Point_t *pPos, GFXObj_t *gfx, Point_t *bgPos, TiledBG_t *bg, unsigned int *matrix[4][3]){
     int conditions = 0;//collision conditions
 
-    int x = fix_norm(*bgPos->getX(bgPos));
-    int y = fix_norm(*bgPos->getY(bgPos));
+    int x = fix_norm(*point_getX(bgPos));
+    int y = fix_norm(*point_getY(bgPos));
 
     //check if bullet is in alien area
     if(obj_collisionArea_Pt(pPos, gfx, x, y, x + (bg->width * bg->tileWd), y + (bg->height * bg->tileHt))){
-        int cX = fix_norm(*pPos->getX(pPos));
-        int cY = fix_norm(*pPos->getY(pPos));
+        int cX = fix_norm(*point_getX(pPos));
+        int cY = fix_norm(*point_getY(pPos));
         int wd = (*BAG_Display_GetGfxFrameWd(gfx));
         int ht = (*BAG_Display_GetGfxFrameHt(gfx));
         conditions = getTileCol(bg, x, y, cX, cY, wd, ht, matrix);   
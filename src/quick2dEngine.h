@@ -17,6 +17,9 @@ extern "C" {
 #define FLIP_LTR(x) (((x) + 128)&511)
 //right to left
 #define FLIP_RTL(x) (((x) - 128)&511)
+//mirror the horizontal or vertical component of an angle
+#define FLIP_HOR(x) ((256 - (x))&511)
+#define FLIP_VERT(x) ((-(x))&511)
 
 typedef enum{
     ANGLE_UP = 384,
@@ -31,20 +34,70 @@ typedef enum{
 
 extern short angle_horFlip(short angle);
 extern short angle_vertFlip(short angle);
+extern short angle_steer(int offset, int range, int dir, int minSteer, int maxSteer);
 
+/*
+Points are plain data. The accessors below are inline, so reading a field in
+a hot loop is a load rather than an indirect call.
+*/
 typedef struct Point_t{
     int x, y, speed, angle;
-
-    int *(*getX)(struct Point_t *);
-    int *(*getY)(struct Point_t *);
-    int *(*getSpeed)(struct Point_t *);
-    int *(*getAngle)(struct Point_t *);
-    char *(*onScreen)(struct Point_t *);
-    void (*update)(struct Point_t *);
+    //fixed point step per update, recomputed when angle or speed change
+    int vx, vy, vAngle, vSpeed;
 }Point_t;
 
+static inline int *point_getX(Point_t *pt){
+    return &pt->x;
+}
+
+static inline int *point_getY(Point_t *pt){
+    return &pt->y;
+}
+
+static inline int *point_getSpeed(Point_t *pt){
+    return &pt->speed;
+}
+
+static inline int *point_getAngle(Point_t *pt){
+    return &pt->angle;
+}
+
+static inline void point_velocity(Point_t *pt){
+    if(pt->angle == pt->vAngle && pt->speed == pt->vSpeed)
+        return;
+    //speed is based on fixed point maths
+    pt->vx = BAG_Cos(pt->angle) * fix_norm(pt->speed);
+    pt->vy = BAG_Sin(pt->angle) * fix_norm(pt->speed);
+    pt->vAngle = pt->angle;
+    pt->vSpeed = pt->speed;
+}
+
+static inline void point_update(Point_t *pt){
+    point_velocity(pt);
+    pt->x += pt->vx;
+    pt->y += pt->vy;
+}
+
+static inline char point_onScreen(Point_t *pt){
+    return (fix_norm(pt->x) >= 0 && fix_norm(pt->x) <= GAME_WIDTH &&
+            fix_norm(pt->y) >= 0 && fix_norm(pt->y) <= GAME_HEIGHT);
+}
 
 extern void initPoint(Point_t *pt);
+extern void point_flipHor(Point_t *pt);
+extern void point_flipVert(Point_t *pt);
+
+//the methods points used to carry, for code that still calls them through pointers
+typedef struct PointMethods_t{
+    int *(*getX)(Point_t *);
+    int *(*getY)(Point_t *);
+    int *(*getSpeed)(Point_t *);
+    int *(*getAngle)(Point_t *);
+    char (*onScreen)(Point_t *);
+    void (*update)(Point_t *);
+}PointMethods_t;
+
+extern const PointMethods_t Point_Methods;
 
 typedef enum{
     COLLISION_UP = (1<<1),
@@ -61,6 +114,27 @@ extern int obj_collisionArea_Pt(Point_t *pt, GFXObj_t *gfx, int x1, int y1, int
 extern int obj_collisionTile(GFXObj_t *gfx, Point_t *bgPos, TiledBG_t *bg, unsigned int *matrix[4][3]);
 extern int obj_collisionTile_Pt(Point_t *pPos, GFXObj_t *gfx, Point_t *bgPos, TiledBG_t *bg, unsigned int *matrix[4][3]);
 
+//map of one byte tiles, 0 is empty
+typedef struct TileGrid_t{
+    unsigned char *tiles;
+    int width, height;//in tiles
+    int tileWd, tileHt;
+    int divX, divY;//shifts for tile dimensions
+}TileGrid_t;
+
+extern int grid_getTile(TileGrid_t *grid, int x, int y);
+extern unsigned char *grid_getTileAddr(TileGrid_t *grid, int x, int y);
+
+//first tile hit by a moving box
+typedef struct TileHit_t{
+    unsigned char *tile;
+    int tileX, tileY;
+    int x, y;//fixed point position of the box when it touched the tile
+}TileHit_t;
+
+extern int obj_sweepTile(int x, int y, int wd, int ht, int dx, int dy, Point_t *bgPos, TileGrid_t *bg, TileHit_t *hit);
+extern int obj_sweepRowsOccupied(int y, int ht, int dy, Point_t *bgPos, TileGrid_t *bg, const unsigned int *rows);
+
 
 
 #ifdef __cplusplus
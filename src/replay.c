@@ -0,0 +1,192 @@
+#include "replay.h"
+
+#define WRITE32(p, v) ((p)[0] = (v), (p)[1] = (v) >> 8, (p)[2] = (v) >> 16, (p)[3] = (v) >> 24)
+#define READ16(p) ((p)[0] | ((p)[1] << 8))
+#define READ32(p) ((p)[0] | ((p)[1] << 8) | ((p)[2] << 16) | ((unsigned int)(p)[3] << 24))
+
+static unsigned int buttonsToMask(const PadButtons_t *b){
+    return b->A | (b->B << 1) | (b->X << 2) | (b->Y << 3) |
+           (b->L << 4) | (b->R << 5) | (b->Start << 6) | (b->Select << 7) |
+           (b->Up << 8) | (b->Down << 9) | (b->Left << 10) | (b->Right << 11) |
+           (b->Touch << 12);
+}
+
+static void maskToButtons(unsigned int mask, PadButtons_t *b){
+    memset(b, 0, sizeof(PadButtons_t));
+    b->A = mask & 1;
+    b->B = (mask >> 1) & 1;
+    b->X = (mask >> 2) & 1;
+    b->Y = (mask >> 3) & 1;
+    b->L = (mask >> 4) & 1;
+    b->R = (mask >> 5) & 1;
+    b->Start = (mask >> 6) & 1;
+    b->Select = (mask >> 7) & 1;
+    b->Up = (mask >> 8) & 1;
+    b->Down = (mask >> 9) & 1;
+    b->Left = (mask >> 10) & 1;
+    b->Right = (mask >> 11) & 1;
+    b->Touch = (mask >> 12) & 1;
+}
+
+unsigned int Replay_PadToMask(const Pad_t *pad){
+    return buttonsToMask(&pad->Held) | (buttonsToMask(&pad->Newpress) << REPLAY_NEWPRESS_SHIFT);
+}
+
+void Replay_MaskToPad(unsigned int mask, unsigned int lastMask, Pad_t *pad){
+    unsigned int held = mask & 0xffff;
+    maskToButtons(held, &pad->Held);
+    maskToButtons(mask >> REPLAY_NEWPRESS_SHIFT, &pad->Newpress);
+    maskToButtons(lastMask & ~held & 0xffff, &pad->Released);
+}
+
+unsigned int Replay_Hash(unsigned int hash, const int *data, int count){
+    for(int i = 0; i < count; i++)
+        hash = (hash ^ (unsigned int)data[i]) * 16777619u;
+    return hash;
+}
+
+void Replay_Free(Replay_t *replay){
+    free(replay->stream);
+    free(replay->hashes);
+    memset(replay, 0, sizeof(Replay_t));
+}
+
+static int putVarint(Replay_t *replay, unsigned long value){
+    //5 bytes holds any 32 bit value
+    if(replay->size + 5 > replay->capacity){
+        unsigned long capacity = replay->capacity ? replay->capacity << 1 : 256;
+        unsigned char *temp = realloc(replay->stream, capacity);
+        if(!temp)
+            return 0;
+        replay->stream = temp;
+        replay->capacity = capacity;
+    }
+    do{
+        unsigned char byte = value & 0x7f;
+        value >>= 7;
+        replay->stream[replay->size++] = byte | (value ? 0x80 : 0);
+    }while(value);
+    return 1;
+}
+
+static int getVarint(Replay_t *replay, unsigned long *value){
+    *value = 0;
+    for(int shift = 0; replay->pos < replay->size && shift < 35; shift += 7){
+        unsigned char byte = replay->stream[replay->pos++];
+        *value |= (unsigned long)(byte & 0x7f) << shift;
+        if(!(byte & 0x80))
+            return 1;
+    }
+    return 0;
+}
+
+int Replay_Record(Replay_t *replay, unsigned int mask, unsigned int hash){
+    if(replay->steps >= replay->hashCapacity){
+        unsigned long capacity = replay->hashCapacity ? replay->hashCapacity << 1 : 1024;
+        unsigned int *temp = realloc(replay->hashes, capacity * sizeof(unsigned int));
+        if(!temp)
+            return 0;
+        replay->hashes = temp;
+        replay->hashCapacity = capacity;
+    }
+
+    //only changes are stored, steps are all the same while the pad is
+    if(mask != replay->mask){
+        if(!putVarint(replay, replay->steps - replay->lastChange) || !putVarint(replay, mask ^ replay->mask))
+            return 0;
+        replay->lastChange = replay->steps;
+        replay->mask = mask;
+    }
+    replay->hashes[replay->steps++] = hash;
+    return 1;
+}
+
+int Replay_Save(Replay_t *replay, const char *file){
+    FILE *fp = fopen(file, "wb");
+    if(!fp)
+        return 0;
+
+    unsigned char header[REPLAY_HEADER_SIZE] = {0};
+    memcpy(header, REPLAY_MAGIC, 4);
+    header[4] = REPLAY_VERSION;
+    header[6] = REPLAY_HASHES;
+    WRITE32(&header[8], replay->steps);
+    WRITE32(&header[12], replay->size);
+    int ok = fwrite(header, REPLAY_HEADER_SIZE, 1, fp) == 1 &&
+             (!replay->size || fwrite(replay->stream, replay->size, 1, fp) == 1);
+
+    for(unsigned long i = 0; ok && i < replay->steps; i++){
+        unsigned char hash[4];
+        WRITE32(hash, replay->hashes[i]);
+        ok = fwrite(hash, 4, 1, fp) == 1;
+    }
+    return (fclose(fp) == 0) && ok;
+}
+
+//queue the next change in the stream, none left puts it past the last step
+static void nextChange(Replay_t *replay){
+    unsigned long run, change;
+    if(getVarint(replay, &run) && getVarint(replay, &change)){
+        replay->nextChange += run;
+        replay->change = change;
+    }
+    else
+        replay->nextChange = ~0ul;
+}
+
+int Replay_Load(Replay_t *replay, const char *file){
+    memset(replay, 0, sizeof(Replay_t));
+    FILE *fp = fopen(file, "rb");
+    if(!fp)
+        return REPLAY_ERR_NOFILE;
+
+    unsigned char header[REPLAY_HEADER_SIZE];
+    if(fread(header, REPLAY_HEADER_SIZE, 1, fp) != 1 || memcmp(header, REPLAY_MAGIC, 4) ||
+       READ16(&header[4]) != REPLAY_VERSION){
+        fclose(fp);
+        return REPLAY_ERR_FORMAT;
+    }
+
+    int flags = READ16(&header[6]), err = REPLAY_OK;
+    replay->steps = READ32(&header[8]);
+    replay->size = replay->capacity = READ32(&header[12]);
+    replay->stream = malloc(replay->size ? replay->size : 1);
+    if(flags & REPLAY_HASHES){
+        replay->hashCapacity = replay->steps;
+        replay->hashes = malloc((replay->steps ? replay->steps : 1) * sizeof(unsigned int));
+    }
+    if(!replay->stream || ((flags & REPLAY_HASHES) && !replay->hashes))
+        err = REPLAY_ERR_NOMEM;
+    else if(replay->size && fread(replay->stream, replay->size, 1, fp) != 1)
+        err = REPLAY_ERR_FORMAT;
+
+    for(unsigned long i = 0; err == REPLAY_OK && replay->hashes && i < replay->steps; i++){
+        unsigned char hash[4];
+        if(fread(hash, 4, 1, fp) != 1)
+            err = REPLAY_ERR_FORMAT;
+        else
+            replay->hashes[i] = READ32(hash);
+    }
+    fclose(fp);
+
+    if(err != REPLAY_OK){
+        Replay_Free(replay);
+        return err;
+    }
+    nextChange(replay);
+    return REPLAY_OK;
+}
+
+int Replay_Next(Replay_t *replay, unsigned int *mask, unsigned int *hash){
+    if(replay->step >= replay->steps)
+        return 0;
+
+    if(replay->step == replay->nextChange){
+        replay->mask ^= replay->change;
+        nextChange(replay);
+    }
+    *mask = replay->mask;
+    *hash = replay->hashes ? replay->hashes[replay->step] : 0;
+    replay->step++;
+    return 1;
+}
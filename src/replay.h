@@ -0,0 +1,67 @@
+#ifndef _REPLAY_H_
+#define _REPLAY_H_
+
+#include <libBAG.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+Pad recordings, one button mask per game step. Held buttons are in bits 0-12
+and new presses in bits 16-28, in the order A B X Y L R Start Select Up Down
+Left Right Touch. Released buttons are worked out from the held ones again.
+Little endian .rpl file:
+    "ARPL", u16 version, u16 flags, u32 steps, u32 stream size
+then the stream of changes, each a varint count of steps since the last change
+and a varint xor against the mask before it, then a u32 state hash per step
+with REPLAY_HASHES set.
+*/
+#define REPLAY_MAGIC "ARPL"
+#define REPLAY_VERSION 1
+#define REPLAY_HEADER_SIZE 16
+#define REPLAY_HASHES 1
+#define REPLAY_NEWPRESS_SHIFT 16
+
+//FNV-1a a word at a time, Replay_Hash(REPLAY_HASH_SEED, ...) starts a new hash
+#define REPLAY_HASH_SEED 2166136261u
+
+typedef enum{
+    REPLAY_OK = 0,
+    REPLAY_ERR_NOFILE,
+    REPLAY_ERR_FORMAT,
+    REPLAY_ERR_NOMEM,
+}REPLAY_ERRORS;
+
+typedef struct Replay_t{
+    unsigned char *stream;
+    unsigned int *hashes;
+    unsigned long size, capacity;//of stream in bytes
+    unsigned long steps, hashCapacity;
+
+    unsigned int mask;//of the last step recorded or played
+    unsigned long lastChange;//recording, step the mask last changed on
+    //playback, where it is in the stream and the next change waiting
+    unsigned long step, pos, nextChange;
+    unsigned int change;
+}Replay_t;
+
+extern unsigned int Replay_PadToMask(const Pad_t *pad);
+extern void Replay_MaskToPad(unsigned int mask, unsigned int lastMask, Pad_t *pad);
+extern unsigned int Replay_Hash(unsigned int hash, const int *data, int count);
+
+extern void Replay_Free(Replay_t *replay);
+//add a step, the mask it ran with and the state hash after it
+extern int Replay_Record(Replay_t *replay, unsigned int mask, unsigned int hash);
+extern int Replay_Save(Replay_t *replay, const char *file);
+
+//REPLAY_OK or the REPLAY_ERRORS reason, the replay is left ready to play from the first step
+extern int Replay_Load(Replay_t *replay, const char *file);
+//mask of the next step and the hash recorded after it, 0 past the last step
+extern int Replay_Next(Replay_t *replay, unsigned int *mask, unsigned int *hash);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
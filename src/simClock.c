@@ -0,0 +1,16 @@
+#include "simClock.h"
+
+void SimClock_Start(SimClock_t *clock, unsigned int now){
+    clock->last = now;
+    clock->pending = SIM_TICKS;
+}
+
+int SimClock_Steps(SimClock_t *clock, unsigned int now){
+    //unsigned, so the timer wrapping around still gives the right difference
+    clock->pending += now - clock->last;
+    clock->last = now;
+
+    unsigned int steps = clock->pending / SIM_TICKS;
+    clock->pending -= steps * SIM_TICKS;
+    return (steps > SIM_MAX_STEPS) ? SIM_MAX_STEPS : steps;
+}
@@ -0,0 +1,33 @@
+#ifndef _SIMCLOCK_H_
+#define _SIMCLOCK_H_
+
+#include <libBAG.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+Fixed step simulation. The game moves on in steps of SIM_TICKS system ticks
+however often frames are drawn, a slow frame runs the steps it fell behind by
+before the next draw and a fast one runs none.
+*/
+#define SYS_TIME_HZ 23437//getSysTime ticks a second, 42.667us each
+#define SIM_HZ 120//rate the game's speeds are tuned for
+#define SIM_TICKS (SYS_TIME_HZ / SIM_HZ)
+//further behind than this and the rest is dropped, the game slows down instead
+#define SIM_MAX_STEPS 16
+
+typedef struct SimClock_t{
+    unsigned int last, pending;
+}SimClock_t;
+
+//the first call to SimClock_Steps after this always runs one step
+extern void SimClock_Start(SimClock_t *clock, unsigned int now);
+extern int SimClock_Steps(SimClock_t *clock, unsigned int now);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,136 @@
+#include "skinCache.h"
+#include "sprite.h"
+#include "game.h"
+
+static const char *PartFiles[SKIN_PARTS] = {"paddle", "ball", "powerups"};
+
+static GAME_LOCAL Skin_t Skins[SKIN_CACHE_MAX];
+static GAME_LOCAL unsigned long UseCount;
+
+static void freeSkin(Skin_t *skin){
+    Sprite_Free(&skin->atlas);
+    Sprite_Free(&skin->background);
+    Sprite_Free(&skin->bricks);
+    memset(skin, 0, sizeof(Skin_t));
+}
+
+//decode every part, stack them down one atlas and let the decoded sheets go
+static int loadAtlas(Skin_t *skin, const char *dir){
+    char path[MAX_PATH];
+    GFXObj_t sheets[SKIN_PARTS];
+    memset(sheets, 0, sizeof(sheets));
+
+    int wd = 0, ht = 0, ok = 1;
+    for(int i = 0; i < SKIN_PARTS && ok; i++){
+        sprintf(path, "%s%s/%s", dir, skin->name, PartFiles[i]);
+        if(Sprite_Load(path, &sheets[i]) != SPRITE_OK){
+            printf("error loading %s\n", path);
+            ok = 0;
+            break;
+        }
+
+        SkinPart_t *part = &skin->parts[i];
+        part->wd = Sprite_Width(&sheets[i]);
+        part->ht = Sprite_Height(&sheets[i]);
+        part->frameWd = *BAG_Display_GetGfxFrameWd(&sheets[i]);
+        part->frameHt = *BAG_Display_GetGfxFrameHt(&sheets[i]);
+        if(part->wd > SKIN_ATLAS_WD){
+            printf("%s is wider than the atlas\n", path);
+            ok = 0;
+            break;
+        }
+        part->y = ht;
+        ht += part->ht;
+        if(part->wd > wd)
+            wd = part->wd;
+    }
+
+    if(ok && Sprite_Create(&skin->atlas, wd, ht, wd, ht) != SPRITE_OK)
+        ok = 0;
+    if(ok){
+        unsigned short *atlas = BAG_Display_GetGfxBuf(&skin->atlas);
+        for(int i = 0; i < wd * ht; i++)
+            atlas[i] = TRANS_COLOR;
+
+        for(int i = 0; i < SKIN_PARTS; i++){
+            SkinPart_t *part = &skin->parts[i];
+            unsigned short *src = BAG_Display_GetGfxBuf(&sheets[i]);
+            for(int row = 0; row < part->ht; row++)
+                memcpy(&atlas[(part->y + row) * wd], &src[row * part->wd], part->wd * sizeof(unsigned short));
+        }
+    }
+
+    for(int i = 0; i < SKIN_PARTS; i++)
+        Sprite_Free(&sheets[i]);
+    return ok;
+}
+
+static int loadSkin(Skin_t *skin, const char *dir, const char *name){
+    char path[MAX_PATH];
+    strncpy(skin->name, name, SKIN_NAME_LEN - 1);
+
+    if(!loadAtlas(skin, dir))
+        return 0;
+
+    sprintf(path, "%s%s/background", dir, name);
+    if(Sprite_Load(path, &skin->background) != SPRITE_OK){
+        printf("error loading %s\n", path);
+        return 0;
+    }
+    sprintf(path, "%s%s/brickTiles", dir, name);
+    if(Sprite_Load(path, &skin->bricks) != SPRITE_OK){
+        printf("error loading %s\n", path);
+        return 0;
+    }
+    return 1;
+}
+
+Skin_t *SkinCache_Get(const char *dir, const char *name){
+    Skin_t *slot = NULL;
+    for(int i = 0; i < SKIN_CACHE_MAX; i++){
+        if(Skins[i].name[0] && !strncmp(Skins[i].name, name, SKIN_NAME_LEN - 1)){
+            Skins[i].lastUse = ++UseCount;
+            return &Skins[i];
+        }
+        //otherwise replace whichever skin went unused the longest, views still point into held ones
+        if(!Skins[i].holds && (!slot || Skins[i].lastUse < slot->lastUse))
+            slot = &Skins[i];
+    }
+
+    if(!slot){
+        printf("no free skin slot for %s\n", name);
+        return NULL;
+    }
+    freeSkin(slot);
+    if(!loadSkin(slot, dir, name)){
+        freeSkin(slot);
+        return NULL;
+    }
+    slot->lastUse = ++UseCount;
+    return slot;
+}
+
+void SkinCache_View(Skin_t *skin, SKIN_PART part, GFXObj_t *view){
+    SkinPart_t *rect = &skin->parts[part];
+    SkinCache_ViewSheet(&skin->atlas, view);
+    *BAG_Display_GetGfxOffsetY(view) = rect->y;
+    BAG_Display_SetGfxFrameDim(view, rect->frameWd, rect->frameHt);
+}
+
+void SkinCache_ViewSheet(GFXObj_t *sheet, GFXObj_t *view){
+    memcpy(view, sheet, sizeof(GFXObj_t));
+}
+
+void SkinCache_Hold(Skin_t *skin){
+    skin->holds++;
+}
+
+void SkinCache_Release(Skin_t *skin){
+    if(skin->holds > 0)
+        skin->holds--;
+}
+
+void SkinCache_Flush(void){
+    for(int i = 0; i < SKIN_CACHE_MAX; i++)
+        freeSkin(&Skins[i]);
+}
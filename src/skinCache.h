@@ -0,0 +1,62 @@
+#ifndef _SKINCACHE_H_
+#define _SKINCACHE_H_
+
+#include <libBAG.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+Skins are decoded once and kept by name. The paddle, ball and power-up sheets
+of a skin are stacked down one atlas, and the game draws them through views:
+copies of the atlas object that share its buffer, with the vertical offset
+pointing at their part. Views must never be deleted. The paddle always sits at
+the top of the atlas since its animations set the vertical offset directly.
+Every part starts at the left edge, so views only ever move the vertical offset.
+
+A skin with views in use must be held, held skins are never evicted to make
+room for another.
+*/
+#define SKIN_CACHE_MAX 4
+#define SKIN_NAME_LEN 32
+#define SKIN_ATLAS_WD 256//widest part
+
+typedef enum{
+    SKIN_PADDLE,
+    SKIN_BALL,
+    SKIN_POWERUPS,
+    SKIN_PARTS,
+}SKIN_PART;
+
+typedef struct SkinPart_t{
+    int y, wd, ht;
+    int frameWd, frameHt;//as the sheet was loaded
+}SkinPart_t;
+
+typedef struct Skin_t{
+    char name[SKIN_NAME_LEN];
+    GFXObj_t atlas;
+    SkinPart_t parts[SKIN_PARTS];
+    GFXObj_t background, bricks;
+    unsigned long lastUse;
+    int holds;
+}Skin_t;
+
+//skin from the cache, decoded from dir/name/ the first time it is asked for,
+//NULL when it can not be loaded or every slot is held
+extern Skin_t *SkinCache_Get(const char *dir, const char *name);
+//point view at one part of a skins atlas
+extern void SkinCache_View(Skin_t *skin, SKIN_PART part, GFXObj_t *view);
+//view of a whole sheet kept outside the atlas
+extern void SkinCache_ViewSheet(GFXObj_t *sheet, GFXObj_t *view);
+//every hold needs a release once the views into the skin are no longer drawn
+extern void SkinCache_Hold(Skin_t *skin);
+extern void SkinCache_Release(Skin_t *skin);
+extern void SkinCache_Flush(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,248 @@
+#include "snapshot.h"
+
+#define RUN_MAX 0xffff
+#define SNAPSHOT_BLOCK 16//words compared at once
+
+int Snapshot_Init(Snapshot_t *snap, unsigned long ringSize){
+    memset(snap, 0, sizeof(Snapshot_t));
+    snap->ringSize = ringSize / sizeof(unsigned int);
+    snap->ring = malloc(snap->ringSize * sizeof(unsigned int));
+    return snap->ring != NULL;
+}
+
+void Snapshot_Free(Snapshot_t *snap){
+    free(snap->ring);
+    free(snap->image);
+    free(snap->delta);
+    memset(snap, 0, sizeof(Snapshot_t));
+}
+
+void Snapshot_Reset(Snapshot_t *snap){
+    snap->regionCount = 0;
+    snap->words = 0;
+    snap->primed = 0;
+    snap->head = snap->used = 0;
+    snap->first = snap->count = 0;
+}
+
+int Snapshot_AddRegion(Snapshot_t *snap, void *data, int size){
+    //compared a word at a time, the device can not load words that are not aligned
+    if(snap->regionCount >= SNAPSHOT_REGIONS_MAX || snap->primed || size <= 0 || ((unsigned long)data & 3))
+        return 0;
+
+    unsigned long words = snap->words + (size + 3) / 4;
+    if(words > snap->capacity){
+        //a difference is at worst a run header for every word
+        unsigned int *image = realloc(snap->image, words * sizeof(unsigned int)),
+                     *delta = realloc(snap->delta, (2 * words + 1) * sizeof(unsigned int));
+        if(image)
+            snap->image = image;
+        if(delta)
+            snap->delta = delta;
+        if(!image || !delta)
+            return 0;
+        snap->capacity = words;
+    }
+    SnapshotRegion_t *region = &snap->regions[snap->regionCount++];
+    region->data = data;
+    region->size = size;
+    region->count = NULL;
+    region->elemSize = 0;
+    snap->words = words;
+    return 1;
+}
+
+int Snapshot_AddArray(Snapshot_t *snap, void *data, int elemSize, int max, const int *count){
+    if(!Snapshot_AddRegion(snap, data, elemSize * max))
+        return 0;
+    SnapshotRegion_t *region = &snap->regions[snap->regionCount - 1];
+    region->count = count;
+    region->elemSize = elemSize;
+    return 1;
+}
+
+typedef struct Encoder_t{
+    unsigned int *out;
+    unsigned long n, header;//header of the changed run open, 0 when there is none
+    unsigned int same, changed;
+}Encoder_t;
+
+static void closeRun(Encoder_t *enc){
+    enc->out[enc->header] |= enc->changed << 16;
+    enc->header = enc->changed = 0;
+}
+
+//compare words of a region with the image, keeping the image up to date
+static void encodeWords(Encoder_t *enc, const unsigned int *cur, unsigned int *image, unsigned long words){
+    for(unsigned long i = 0; i < words; i++){
+        //whole blocks that have not changed are the common case
+        if(!enc->header && !(i & (SNAPSHOT_BLOCK - 1)) && i + SNAPSHOT_BLOCK <= words &&
+           !memcmp(&cur[i], &image[i], SNAPSHOT_BLOCK * sizeof(unsigned int))){
+            if(enc->same + SNAPSHOT_BLOCK > RUN_MAX){
+                enc->out[enc->n++] = enc->same;
+                enc->same = 0;
+            }
+            enc->same += SNAPSHOT_BLOCK;
+            i += SNAPSHOT_BLOCK - 1;
+            continue;
+        }
+
+        if(cur[i] == image[i]){
+            if(enc->header)
+                closeRun(enc);
+            if(enc->same == RUN_MAX){
+                enc->out[enc->n++] = enc->same;
+                enc->same = 0;
+            }
+            enc->same++;
+            continue;
+        }
+
+        if(!enc->header){
+            enc->header = enc->n;
+            enc->out[enc->n++] = enc->same;
+            enc->same = 0;
+        }
+        enc->out[enc->n++] = cur[i] ^ image[i];
+        image[i] = cur[i];
+        if(++enc->changed == RUN_MAX)
+            closeRun(enc);
+    }
+}
+
+//words not compared this capture, the image keeps what they were
+static void skipWords(Encoder_t *enc, unsigned long words){
+    if(words && enc->header)
+        closeRun(enc);
+    while(words){
+        if(enc->same == RUN_MAX){
+            enc->out[enc->n++] = enc->same;
+            enc->same = 0;
+        }
+        unsigned long n = RUN_MAX - enc->same;
+        if(n > words)
+            n = words;
+        enc->same += n;
+        words -= n;
+    }
+}
+
+static void unpack(Snapshot_t *snap, const unsigned int *src){
+    for(int i = 0; i < snap->regionCount; i++){
+        SnapshotRegion_t *region = &snap->regions[i];
+        memcpy(region->data, src, region->size);
+        src += (region->size + 3) / 4;
+    }
+}
+
+static void decode(const unsigned int *in, unsigned long size, unsigned int *image){
+    for(unsigned long n = 0; n < size;){
+        unsigned int run = in[n++];
+        image += run & RUN_MAX;
+        for(unsigned int j = 0; j < (run >> 16); j++)
+            *image++ ^= in[n++];
+    }
+}
+
+static void dropOldest(Snapshot_t *snap){
+    snap->used -= snap->entries[snap->first].size;
+    snap->first = (snap->first + 1) % SNAPSHOT_ENTRIES_MAX;
+    snap->count--;
+}
+
+static void store(Snapshot_t *snap, const unsigned int *delta, unsigned long size){
+    if(size > snap->ringSize){
+        //too big to ever keep, history starts again from here
+        snap->first = snap->count = 0;
+        snap->head = snap->used = 0;
+        return;
+    }
+    //going back to the start leaves the end of the ring behind, anything still there goes too
+    unsigned long tail = snap->ringSize;
+    if(snap->head + size > snap->ringSize){
+        tail = snap->head;
+        snap->head = 0;
+    }
+    //make room, the oldest differences are the ones ahead of head
+    while(snap->count){
+        SnapshotEntry_t *old = &snap->entries[snap->first];
+        if(snap->count < SNAPSHOT_ENTRIES_MAX && old->offset < tail &&
+           (old->offset >= snap->head + size || old->offset + old->size <= snap->head))
+            break;
+        dropOldest(snap);
+    }
+
+    SnapshotEntry_t *entry = &snap->entries[(snap->first + snap->count) % SNAPSHOT_ENTRIES_MAX];
+    entry->offset = snap->head;
+    entry->size = size;
+    memcpy(&snap->ring[snap->head], delta, size * sizeof(unsigned int));
+    snap->head += size;
+    snap->used += size;
+    snap->count++;
+}
+
+int Snapshot_Capture(Snapshot_t *snap){
+    if(!snap->ring || !snap->regionCount)
+        return 0;
+
+    //the first capture only fills in the image. delta[0] is left unused so a
+    //header at 0 can mean no run is open
+    Encoder_t enc = {snap->delta, 1, 0, 0, 0};
+    unsigned int *image = snap->image;
+    for(int i = 0; i < snap->regionCount; i++){
+        SnapshotRegion_t *region = &snap->regions[i];
+        unsigned long words = region->size / 4, live = words;
+        if(region->count){
+            live = ((unsigned long)*region->count * region->elemSize + 3) / 4;
+            if(live > words)
+                live = words;
+        }
+        if(snap->primed){
+            encodeWords(&enc, region->data, image, live);
+            skipWords(&enc, words - live);
+        }
+        else
+            memcpy(image, region->data, words * sizeof(unsigned int));
+
+        //the end of a region that is not whole words, the rest of the word is always 0
+        if(region->size & 3){
+            unsigned int last = 0;
+            memcpy(&last, (unsigned char *)region->data + words * 4, region->size & 3);
+            if(snap->primed)
+                encodeWords(&enc, &last, &image[words], 1);
+            else
+                image[words] = last;
+            words++;
+        }
+        image += words;
+    }
+    if(enc.header)
+        closeRun(&enc);
+
+    if(snap->primed)
+        store(snap, &snap->delta[1], enc.n - 1);
+    snap->primed = 1;
+    return 1;
+}
+
+int Snapshot_Rewind(Snapshot_t *snap, int steps){
+    int went = 0;
+    for(; went < steps && snap->count; went++){
+        SnapshotEntry_t *entry = &snap->entries[(snap->first + snap->count - 1) % SNAPSHOT_ENTRIES_MAX];
+        decode(&snap->ring[entry->offset], entry->size, snap->image);
+        snap->head = entry->offset;
+        snap->used -= entry->size;
+        snap->count--;
+    }
+    if(went)
+        unpack(snap, snap->image);
+    return went;
+}
+
+int Snapshot_Count(Snapshot_t *snap){
+    return snap->count;
+}
+
+unsigned long Snapshot_Bytes(Snapshot_t *snap){
+    return snap->used * sizeof(unsigned int);
+}
@@ -0,0 +1,73 @@
+#ifndef _SNAPSHOT_H_
+#define _SNAPSHOT_H_
+
+#include <libBAG.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+History of game states for rewinding. The regions of memory that make up the
+state are compared against an image of them as of the last capture, and only
+how they differ is kept: runs of u16 unchanged words and u16 changed words in
+one word, then the changed words xored with what the image had. Rewinding xors
+the newest difference back into the image, so it goes back a capture at a
+time. Differences are kept in a ring allocated up front, when it is full the
+oldest are dropped.
+
+An array region only compares the elements in use, up to a count read at each
+capture. The image keeps whatever the rest held last.
+*/
+#define SNAPSHOT_REGIONS_MAX 32
+#define SNAPSHOT_ENTRIES_MAX 4096//captures kept at most, whatever their size
+
+typedef struct SnapshotRegion_t{
+    void *data;
+    int size;//in bytes
+    const int *count;//elements in use of an array region, NULL for all of it
+    int elemSize;
+}SnapshotRegion_t;
+
+typedef struct SnapshotEntry_t{
+    unsigned long offset, size;//in the ring
+}SnapshotEntry_t;
+
+typedef struct Snapshot_t{
+    SnapshotRegion_t regions[SNAPSHOT_REGIONS_MAX];
+    int regionCount;
+    //regions as of the newest capture, the next capture is encoded in to delta
+    unsigned int *image, *delta;
+    unsigned long words, capacity;//of image, in words
+    char primed;//image holds a capture
+
+    //sizes and offsets in the ring are in words too
+    unsigned int *ring;
+    unsigned long ringSize, head, used;//head is where the next difference goes
+    SnapshotEntry_t entries[SNAPSHOT_ENTRIES_MAX];
+    int first, count;
+}Snapshot_t;
+
+//allocates a ring of ringSize bytes, 0 when there is not the memory
+extern int Snapshot_Init(Snapshot_t *snap, unsigned long ringSize);
+extern void Snapshot_Free(Snapshot_t *snap);
+//forget every capture and region, the regions are added again after
+extern void Snapshot_Reset(Snapshot_t *snap);
+//data must be word aligned
+extern int Snapshot_AddRegion(Snapshot_t *snap, void *data, int size);
+//max elements of elemSize bytes, of which only the first *count are captured
+extern int Snapshot_AddArray(Snapshot_t *snap, void *data, int elemSize, int max, const int *count);
+
+extern int Snapshot_Capture(Snapshot_t *snap);
+//write the state from up to steps captures ago back to the regions, returns how far it went
+extern int Snapshot_Rewind(Snapshot_t *snap, int steps);
+//captures that can be rewound to
+extern int Snapshot_Count(Snapshot_t *snap);
+//ring in use by the captures kept
+extern unsigned long Snapshot_Bytes(Snapshot_t *snap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,169 @@
+#include "spanMask.h"
+#include "sprite.h"
+
+//spans of one frame row, counted only when spans is NULL
+static int findSpans(const unsigned short *src, int wd, Span_t *spans){
+    int count = 0;
+    for(int x = 0; x < wd; x++){
+        if(src[x] == TRANS_COLOR)
+            continue;
+        int start = x;
+        while(x < wd && src[x] != TRANS_COLOR)
+            x++;
+        if(spans){
+            spans[count].x = start;
+            spans[count].len = x - start;
+        }
+        count++;
+    }
+    return count;
+}
+
+//row of the sheet a frame row is in, NULL past the edge of the sheet
+static const unsigned short *frameRow(GFXObj_t *gfx, SpanStrip_t *strip, int frame, int row, int *wd){
+    int sheetWd = Sprite_Width(gfx),
+        srcX = frame * strip->frameWd,
+        srcY = strip->y + row;
+    if(srcY >= Sprite_Height(gfx) || srcX >= sheetWd)
+        return NULL;
+
+    *wd = strip->frameWd;
+    if(srcX + *wd > sheetWd)
+        *wd = sheetWd - srcX;
+    return &BAG_Display_GetGfxBuf(gfx)[srcY * sheetWd + srcX];
+}
+
+int SpanMask_AddStrip(SpanMask_t *mask, GFXObj_t *gfx, int y, int frameWd, int frameHt, int frames){
+    if(mask->strips >= SPAN_MASK_STRIPS || BAG_Display_GetGfxBuf(gfx) == NULL || y < 0)
+        return 0;
+    if(mask->strips && mask->buffer != BAG_Display_GetGfxBuf(gfx))
+        return 0;
+
+    SpanStrip_t *strip = &mask->strip[mask->strips];
+    memset(strip, 0, sizeof(SpanStrip_t));
+    strip->y = y;
+    strip->frameWd = frameWd;
+    strip->frameHt = frameHt;
+    strip->frames = frames;
+
+    int rows = frames * frameHt, count = 0, wd;
+    strip->rows = malloc((rows + 1) * sizeof(int));
+    if(strip->rows == NULL)
+        return 0;
+    for(int i = 0; i < rows; i++){
+        const unsigned short *src = frameRow(gfx, strip, i / frameHt, i % frameHt, &wd);
+        strip->rows[i] = count;
+        if(src)
+            count += findSpans(src, wd, NULL);
+    }
+    strip->rows[rows] = count;
+
+    strip->spans = malloc((count ? count : 1) * sizeof(Span_t));
+    if(strip->spans == NULL){
+        free(strip->rows);
+        return 0;
+    }
+    for(int i = 0; i < rows; i++){
+        const unsigned short *src = frameRow(gfx, strip, i / frameHt, i % frameHt, &wd);
+        if(src)
+            findSpans(src, wd, &strip->spans[strip->rows[i]]);
+    }
+
+    mask->buffer = BAG_Display_GetGfxBuf(gfx);
+    mask->sheetWd = Sprite_Width(gfx);
+    mask->strips++;
+    return 1;
+}
+
+void SpanMask_Free(SpanMask_t *mask){
+    for(int i = 0; i < mask->strips; i++){
+        free(mask->strip[i].rows);
+        free(mask->strip[i].spans);
+    }
+    memset(mask, 0, sizeof(SpanMask_t));
+}
+
+const SpanStrip_t *SpanMask_Find(const SpanMask_t *mask, GFXObj_t *gfx, int frame){
+    if(mask == NULL || mask->buffer != BAG_Display_GetGfxBuf(gfx))
+        return NULL;
+
+    int wd = *BAG_Display_GetGfxFrameWd(gfx),
+        ht = *BAG_Display_GetGfxFrameHt(gfx),
+        y = *BAG_Display_GetGfxOffsetY(gfx);//animations move down the sheet by pixel offset
+
+    for(int i = 0; i < mask->strips; i++){
+        const SpanStrip_t *strip = &mask->strip[i];
+        if(strip->y == y && strip->frameWd == wd && strip->frameHt == ht &&
+           frame >= 0 && frame < strip->frames)
+            return strip;
+    }
+    return NULL;
+}
+
+void SpanMask_DrawStrip(const SpanMask_t *mask, const SpanStrip_t *strip, int frame, int x, int y,
+                        unsigned short *dest, int destWd, int destHt){
+    int first = (y < 0) ? -y : 0,
+        last = (y + strip->frameHt > destHt) ? destHt - y : strip->frameHt;
+    if(x >= destWd || x + strip->frameWd <= 0)
+        return;
+
+    const unsigned short *src = &mask->buffer[strip->y * mask->sheetWd + frame * strip->frameWd];
+    const int *rows = &strip->rows[frame * strip->frameHt];
+    for(int i = first; i < last; i++){
+        const Span_t *span = &strip->spans[rows[i]], *end = &strip->spans[rows[i + 1]];
+        for(; span < end; span++){
+            int sx = span->x, len = span->len;
+            if(x + sx < 0){
+                len += x + sx;
+                sx = -x;
+            }
+            if(x + sx + len > destWd)
+                len = destWd - x - sx;
+            if(len <= 0)
+                continue;
+
+            unsigned short *to = &dest[(y + i) * destWd + x + sx];
+            const unsigned short *from = &src[i * mask->sheetWd + sx];
+            //a call costs more than a ball's few pixels
+            if(len > SPAN_SHORT_RUN)
+                Blit.copy(to, from, len);
+            else{
+                switch(len){
+                    case 8: to[7] = from[7];
+                    case 7: to[6] = from[6];
+                    case 6: to[5] = from[5];
+                    case 5: to[4] = from[4];
+                    case 4: to[3] = from[3];
+                    case 3: to[2] = from[2];
+                    case 2: to[1] = from[1];
+                    case 1: to[0] = from[0];
+                }
+            }
+        }
+    }
+}
+
+void SpanMask_DrawFound(const SpanMask_t *mask, const SpanStrip_t *strip, int frame, GFXObj_t *gfx,
+                        int x, int y, const Surface_t *surface){
+    int ht = strip ? strip->frameHt : *BAG_Display_GetGfxFrameHt(gfx);
+    for(int h = 0; h < 2; h++){
+        int top = h ? surface->seam : 0,
+            bottom = h ? GAME_HEIGHT : surface->seam;
+        if(top >= bottom || y >= bottom || y + ht <= top)
+            continue;
+
+        if(strip)
+            SpanMask_DrawStrip(mask, strip, frame, x, y - top, surface->half[h], GAME_WIDTH, bottom - top);
+        else{
+            BAG_Display_SetGfxBlitXY(gfx, x, y - top);
+            BAG_Display_DrawObjSlowEx(gfx, surface->half[h], GAME_WIDTH, bottom - top);
+        }
+    }
+    if(strip == NULL)
+        BAG_Display_SetGfxBlitXY(gfx, x, y);
+}
+
+void SpanMask_Draw(const SpanMask_t *mask, GFXObj_t *gfx, int frame, const Surface_t *surface){
+    const SpanStrip_t *strip = SpanMask_Find(mask, gfx, frame);
+    SpanMask_DrawFound(mask, strip, frame, gfx, *BAG_Display_GetGfxBlitX(gfx), *BAG_Display_GetGfxBlitY(gfx), surface);
+}
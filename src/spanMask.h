@@ -0,0 +1,58 @@
+#ifndef _SPANMASK_H_
+#define _SPANMASK_H_
+
+#include <libBAG.h>
+#include "blit.h"
+#include "dirtyRect.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+Runs of opaque pixels in a sprite's frames, found once at load time so drawing
+copies each run whole and skips the see through parts without testing them.
+A strip is a row of frames laid across the sheet from the left edge at y the
+way an animation steps through them, one strip per animation. The frame drawn
+is passed in, the gfx only gives the strip's offset and frame size. Sheets
+must come from sprite.h, which knows their size.
+*/
+#define SPAN_MASK_STRIPS 4
+//runs up to this long are copied inline rather than with a blit kernel
+#define SPAN_SHORT_RUN 8
+
+typedef struct Span_t{
+    unsigned short x, len;//x from the left of the frame
+}Span_t;
+
+typedef struct SpanStrip_t{
+    int y, frameWd, frameHt, frames;
+    int *rows;//first span of each frame row, frames * frameHt + 1 of them
+    Span_t *spans;
+}SpanStrip_t;
+
+typedef struct SpanMask_t{
+    const unsigned short *buffer;//sheet the spans were found in
+    int sheetWd, strips;
+    SpanStrip_t strip[SPAN_MASK_STRIPS];
+}SpanMask_t;
+
+extern int SpanMask_AddStrip(SpanMask_t *mask, GFXObj_t *gfx, int y, int frameWd, int frameHt, int frames);
+extern void SpanMask_Free(SpanMask_t *mask);
+//strip for gfx as it is set now, NULL when the mask does not have it or the frame
+extern const SpanStrip_t *SpanMask_Find(const SpanMask_t *mask, GFXObj_t *gfx, int frame);
+//draw a frame found with SpanMask_Find at x,y, clipped to dest
+extern void SpanMask_DrawStrip(const SpanMask_t *mask, const SpanStrip_t *strip, int frame, int x, int y,
+                               unsigned short *dest, int destWd, int destHt);
+//draw a frame found with SpanMask_Find at x,y, split where it crosses the surface's seam.
+//without a strip gfx is drawn with BAG_Display_DrawObjSlowEx
+extern void SpanMask_DrawFound(const SpanMask_t *mask, const SpanStrip_t *strip, int frame, GFXObj_t *gfx,
+                               int x, int y, const Surface_t *surface);
+//draw a frame of gfx at its blit position
+extern void SpanMask_Draw(const SpanMask_t *mask, GFXObj_t *gfx, int frame, const Surface_t *surface);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
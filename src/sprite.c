@@ -0,0 +1,126 @@
+#include "sprite.h"
+#include "game.h"
+
+#define READ16(p) ((p)[0] | ((p)[1] << 8))
+#define READ32BE(p) (((p)[0] << 24) | ((p)[1] << 16) | ((p)[2] << 8) | (p)[3])
+
+typedef struct SpriteSheet_t{
+    const unsigned short *buffer;//NULL when the slot is free
+    int wd, ht;
+}SpriteSheet_t;
+
+static GAME_LOCAL SpriteSheet_t Sheets[SPRITE_SHEETS_MAX];
+
+static SpriteSheet_t *findSheet(const unsigned short *buffer){
+    for(int i = 0; i < SPRITE_SHEETS_MAX; i++){
+        if(Sheets[i].buffer == buffer)
+            return &Sheets[i];
+    }
+    return NULL;
+}
+
+static int addSheet(GFXObj_t *obj, int wd, int ht){
+    const unsigned short *buffer = BAG_Display_GetGfxBuf(obj);
+    SpriteSheet_t *sheet = findSheet(buffer);
+    if(sheet == NULL)
+        sheet = findSheet(NULL);
+    if(sheet == NULL || buffer == NULL)
+        return 0;
+
+    sheet->buffer = buffer;
+    sheet->wd = wd;
+    sheet->ht = ht;
+    return 1;
+}
+
+//size from the IHDR chunk, tried with and without the extension like BAG_Display_LoadObjExt
+static int pngSize(const char *file, int *wd, int *ht){
+    char path[MAX_PATH];
+    unsigned char header[24];
+    snprintf(path, sizeof(path), "%s.png", file);
+    FILE *fp = fopen(path, "rb");
+    if(!fp)
+        fp = fopen(file, "rb");
+    if(!fp)
+        return 0;
+
+    int ok = fread(header, sizeof(header), 1, fp) == 1 && !memcmp(&header[1], "PNG", 3) && !memcmp(&header[12], "IHDR", 4);
+    fclose(fp);
+    if(ok){
+        *wd = READ32BE(&header[16]);
+        *ht = READ32BE(&header[20]);
+    }
+    return ok;
+}
+
+int Sprite_Create(GFXObj_t *obj, int wd, int ht, int frameWd, int frameHt){
+    if(BAG_Display_CreateObj(obj, 16, wd, ht, frameWd, frameHt) != NO_ERR)
+        return SPRITE_ERR_NOMEM;
+    if(!addSheet(obj, wd, ht)){
+        Sprite_Free(obj);
+        return SPRITE_ERR_NOMEM;
+    }
+    return SPRITE_OK;
+}
+
+int Sprite_LoadRaw(const char *file, GFXObj_t *obj){
+    unsigned char header[SPRITE_HEADER_SIZE];
+    FILE *fp = fopen(file, "rb");
+    if(!fp)
+        return SPRITE_ERR_NOFILE;
+
+    if(fread(header, SPRITE_HEADER_SIZE, 1, fp) != 1 || memcmp(header, SPRITE_MAGIC, 4) ||
+       READ16(&header[4]) != SPRITE_VERSION){
+        fclose(fp);
+        return SPRITE_ERR_FORMAT;
+    }
+
+    int wd = READ16(&header[6]), ht = READ16(&header[8]);
+    int err = Sprite_Create(obj, wd, ht, READ16(&header[10]), READ16(&header[12]));
+    if(err == SPRITE_OK && fread(BAG_Display_GetGfxBuf(obj), sizeof(unsigned short), wd * ht, fp) != (size_t)(wd * ht)){
+        Sprite_Free(obj);
+        err = SPRITE_ERR_FORMAT;
+    }
+    fclose(fp);
+    return err;
+}
+
+int Sprite_Load(const char *file, GFXObj_t *obj){
+    char path[MAX_PATH];
+    snprintf(path, sizeof(path), "%s.spr", file);
+    if(Sprite_LoadRaw(path, obj) == SPRITE_OK)
+        return SPRITE_OK;
+
+    int wd, ht;
+    if(BAG_Display_LoadObjExt(file, obj) != NO_ERR)
+        return SPRITE_ERR_NOFILE;
+    if(!pngSize(file, &wd, &ht)){
+        Sprite_Free(obj);
+        return SPRITE_ERR_FORMAT;
+    }
+    if(!addSheet(obj, wd, ht)){
+        Sprite_Free(obj);
+        return SPRITE_ERR_NOMEM;
+    }
+    return SPRITE_OK;
+}
+
+void Sprite_Free(GFXObj_t *obj){
+    const unsigned short *buffer = BAG_Display_GetGfxBuf(obj);
+    SpriteSheet_t *sheet = buffer ? findSheet(buffer) : NULL;
+    if(sheet)
+        memset(sheet, 0, sizeof(SpriteSheet_t));
+    BAG_Display_DeleteObj(obj);
+}
+
+int Sprite_Width(GFXObj_t *obj){
+    const unsigned short *buffer = BAG_Display_GetGfxBuf(obj);
+    SpriteSheet_t *sheet = buffer ? findSheet(buffer) : NULL;
+    return sheet ? sheet->wd : 0;
+}
+
+int Sprite_Height(GFXObj_t *obj){
+    const unsigned short *buffer = BAG_Display_GetGfxBuf(obj);
+    SpriteSheet_t *sheet = buffer ? findSheet(buffer) : NULL;
+    return sheet ? sheet->ht : 0;
+}
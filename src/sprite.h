@@ -0,0 +1,48 @@
+#ifndef _SPRITE_H_
+#define _SPRITE_H_
+
+#include <libBAG.h>
+#include "blit.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+.spr sprites, raw 16bpp pixels ready to copy into a GFXObj_t. Little endian:
+    "R555", u16 version, u16 width, u16 height, u16 frameWd, u16 frameHt, u16 reserved
+then width * height RGB15 pixels, TRANS_COLOR where it is see through.
+
+libBAG does not hand back the size of a sheet, so every sheet the game reads
+pixels from is made here and its size kept by buffer. Views sharing the
+buffer get the same size back.
+*/
+#define SPRITE_MAGIC "R555"
+#define SPRITE_VERSION 1
+#define SPRITE_HEADER_SIZE 16
+#define SPRITE_SHEETS_MAX 16
+
+typedef enum{
+    SPRITE_OK = 0,
+    SPRITE_ERR_NOFILE,
+    SPRITE_ERR_FORMAT,
+    SPRITE_ERR_NOMEM,
+}SPRITE_ERRORS;
+
+//file is given without an extension, .spr is tried first and then the png
+extern int Sprite_Load(const char *file, GFXObj_t *obj);
+//only the .spr, file is the full name
+extern int Sprite_LoadRaw(const char *file, GFXObj_t *obj);
+//blank sheet, pixels left for the caller to fill
+extern int Sprite_Create(GFXObj_t *obj, int wd, int ht, int frameWd, int frameHt);
+//only for sheets made above, never for views
+extern void Sprite_Free(GFXObj_t *obj);
+//size of the sheet obj's buffer belongs to, 0 when it was not made here
+extern int Sprite_Width(GFXObj_t *obj);
+extern int Sprite_Height(GFXObj_t *obj);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif